@@ -0,0 +1,271 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Benchmark harness:
+//      Generates synthetic graphs (see src/generators.h), loads each one
+// through readBasicGraph and times the engines behind the REPL commands
+// one by one:
+//      load, transpose, scc, search, sort, mst prim, mst kruskal, path
+//
+// Only the computation is timed, not the printing of results; search
+// prints as it goes, so its output is sent to a null stream. Source node
+// of search and path is n0. Warnings of the engines are muted as well.
+//
+// Every row reports wall time, edges per second (edges of the graph over
+// wall time) and peak resident memory of the process so far.
+//
+// Usage:
+//       bgaBench.exe [--graph rmat|er|grid|chain|star|all] [--scale <s>]
+//                    [--degree <d>] [--seed <n>] [--repeat <r>]
+//                    [--format json|csv] [--out <file>] [--dir <tmp_dir>]
+//                    [--threads <n>]
+
+#include "../src/generators.h"
+#include "../src/transpose.h"
+#include "../src/scc.h"
+#include "../src/dfs.h"
+#include "../src/topoSort.h"
+#include "../src/mst.h"
+#include "../src/shortestPath.h"
+#include "../src/parallel.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+struct benchResult {
+	string graph_;
+	string op_;
+	size_t nodes_;
+	size_t edges_;
+	double ms_;
+	size_t peakKb_;
+};
+
+// peak resident set size of this process in KB.
+static size_t peak_rss_kb()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+	return pmc.PeakWorkingSetSize / 1024;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#if defined(__APPLE__)
+	return usage.ru_maxrss / 1024; // bytes on macOS.
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// discards everything written to it.
+class nullBuffer : public streambuf {
+protected:
+	int overflow(int c) { return c; }
+	streamsize xsputn(const char*, streamsize n) { return n; }
+};
+
+// wall time of body in ms, with cout and cerr muted.
+template <class BODY>
+static double time_ms(BODY body)
+{
+	static nullBuffer sink;
+	streambuf* out = cout.rdbuf(&sink);
+	streambuf* err = cerr.rdbuf(&sink);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	body();
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout.rdbuf(out);
+	cerr.rdbuf(err);
+	return ms;
+}
+
+static void bench_graph(string kind, size_t scale, size_t degree, uint64_t seed, size_t repeat,
+	string dir, vector<benchResult>& results)
+{
+	stringstream name;
+	name << dir << "/bga_" << kind << "_" << scale << "_" << degree << "_" << seed << ".txt";
+	string file = name.str();
+	if (!generators::write(file, kind, scale, degree, seed))
+		return;
+
+	for (size_t r = 0; r < repeat; r++)
+	{
+		basicGraph::bGraph* graph = nullptr;
+		double loadMs = time_ms([&]() { graph = basicGraph::bGraph::readBasicGraph(file); });
+		if (!graph) {
+			cerr << "Error: graph could not be built from " << file << ".\n";
+			break;
+		}
+		const basicGraph::bNode* src = graph->findNode("n0");
+		if (!src)
+			src = graph->node(0);
+
+		benchResult row = { kind, "load", graph->nNodes(), graph->nEdges(), loadMs, peak_rss_kb() };
+		results.push_back(row);
+
+		vector<pair<string, double>> ops;
+		ops.push_back(make_pair("transpose", time_ms([&]() {
+			transpose reverse(false);
+			delete reverse.build(graph);
+		})));
+		ops.push_back(make_pair("scc", time_ms([&]() {
+			SCC::tarjan scc(graph);
+			scc.build();
+		})));
+		ops.push_back(make_pair("search", time_ms([&]() {
+			DFS traverse(graph);
+			traverse.search(src);
+		})));
+		ops.push_back(make_pair("sort", time_ms([&]() {
+			kahnSort levels(graph);
+			levels.build();
+		})));
+		ops.push_back(make_pair("mst prim", time_ms([&]() {
+			MST::prim mst(graph);
+			mst.build();
+		})));
+		ops.push_back(make_pair("mst kruskal", time_ms([&]() {
+			MST::kruskal mst(graph);
+			mst.build();
+		})));
+		ops.push_back(make_pair("path", time_ms([&]() {
+			short_paths::dijkstra sssp(src, graph);
+			sssp.build();
+		})));
+		for (size_t i = 0; i < ops.size(); i++)
+		{
+			row.op_    = ops[i].first;
+			row.ms_    = ops[i].second;
+			row.peakKb_ = peak_rss_kb();
+			results.push_back(row);
+		}
+		delete graph;
+	}
+	remove(file.c_str());
+}
+
+static double edges_per_sec(const benchResult& r)
+{
+	return r.ms_ > 0 ? r.edges_ / (r.ms_ / 1000.0) : 0.0;
+}
+
+static void write_csv(ostream& out, const vector<benchResult>& results)
+{
+	out << "graph,op,nodes,edges,wall_ms,edges_per_sec,peak_rss_kb\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const benchResult& r = results[i];
+		out << r.graph_ << "," << r.op_ << "," << r.nodes_ << "," << r.edges_ << ","
+			<< r.ms_ << "," << edges_per_sec(r) << "," << r.peakKb_ << "\n";
+	}
+}
+
+static void write_json(ostream& out, const vector<benchResult>& results, size_t scale, size_t degree, uint64_t seed)
+{
+	out << "{\n  \"scale\": " << scale << ", \"degree\": " << degree << ", \"seed\": " << seed
+		<< ", \"threads\": " << parallel::nThreads() << ",\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const benchResult& r = results[i];
+		out << "    {\"graph\": \"" << r.graph_ << "\", \"op\": \"" << r.op_ << "\", \"nodes\": " << r.nodes_
+			<< ", \"edges\": " << r.edges_ << ", \"wall_ms\": " << r.ms_ << ", \"edges_per_sec\": "
+			<< edges_per_sec(r) << ", \"peak_rss_kb\": " << r.peakKb_ << "}"
+			<< (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	out << "  ]\n}\n";
+}
+
+int main(int argc, char** argv)
+{
+	string   kind   = "all";
+	size_t   scale  = 12;
+	size_t   degree = 8;
+	uint64_t seed   = 1;
+	size_t   repeat = 1;
+	string   format = "json";
+	string   outFile;
+	string   dir    = ".";
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (i + 1 >= argc) {
+			cerr << "Error: option " << arg << " needs a value.\n";
+			return 1;
+		}
+		string value = argv[++i];
+		if (arg == "--graph")       kind   = value;
+		else if (arg == "--scale")  scale  = strtoul(value.c_str(), nullptr, 10);
+		else if (arg == "--degree") degree = strtoul(value.c_str(), nullptr, 10);
+		else if (arg == "--seed")   seed   = strtoull(value.c_str(), nullptr, 10);
+		else if (arg == "--repeat") repeat = strtoul(value.c_str(), nullptr, 10);
+		else if (arg == "--format") format = value;
+		else if (arg == "--out")    outFile = value;
+		else if (arg == "--dir")    dir    = value;
+		else if (arg == "--threads") {
+			if (!parallel::setThreads(strtoul(value.c_str(), nullptr, 10))) {
+				cerr << "Error: invalid thread count " << value << ".\n";
+				return 1;
+			}
+		}
+		else {
+			cerr << "Error: option " << arg << " not recognized.\n";
+			return 1;
+		}
+	}
+	if (format != "json" && format != "csv") {
+		cerr << "Error: invalid format " << format << ". Options are json and csv.\n";
+		return 1;
+	}
+	if (scale == 0 || scale > 30 || degree == 0) {
+		cerr << "Error: scale must be in [1, 30] and degree positive.\n";
+		return 1;
+	}
+
+	vector<string> kinds;
+	if (kind == "all") {
+		kinds.push_back("rmat");
+		kinds.push_back("er");
+		kinds.push_back("grid");
+		kinds.push_back("chain");
+		kinds.push_back("star");
+	}
+	else
+		kinds.push_back(kind);
+
+	vector<benchResult> results;
+	for (size_t k = 0; k < kinds.size(); k++)
+		bench_graph(kinds[k], scale, degree, seed, repeat ? repeat : 1, dir, results);
+
+	ofstream file;
+	if (!outFile.empty()) {
+		file.open(outFile.c_str());
+		if (!file) {
+			cerr << "Error: could not open file " << outFile << ".\n";
+			return 1;
+		}
+	}
+	ostream& out = outFile.empty() ? cout : file;
+	if (format == "csv")
+		write_csv(out, results);
+	else
+		write_json(out, results, scale, degree, seed);
+	return 0;
+}
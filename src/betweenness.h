@@ -0,0 +1,256 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Betweenness Centrality (Brandes):
+//      Betweenness of node v is the sum, over all pairs (s, t), of the
+// fraction of shortest s-t paths that pass through v. Nodes with high
+// betweenness are bridges and brokers between parts of the graph.
+//
+//   for each source s
+//      single source shortest paths from s (BFS, or Dijkstra on weighted
+//      graphs), counting sigma[w], the number of shortest paths to w.
+//      for w in order of non-increasing distance from s
+//         for each predecessor v of w on a shortest path
+//            delta[v] += sigma[v] / sigma[w] * (1 + delta[w])
+//         if w != s, score[w] += delta[w]
+//
+// Sources are split over threads; each thread has its own workspace and
+// score array, summed at the end. Predecessors are found again from the
+// in-edges during accumulation, instead of being stored as lists.
+//
+// Sampled mode runs only k random sources and scales scores by n/k. The
+// normalized score (score / ((n-1)(n-2))) of every node is then within
+// sqrt(ln(2n/p) / 2k) of the exact one with probability at least 1-p
+// (Hoeffding bound with a union bound over all nodes).
+//
+// Reference: Brandes, "A Faster Algorithm for Betweenness Centrality", 2001.
+//            Brandes, Pich, "Centrality Estimation in Large Networks", 2007.
+
+#ifndef GRAPH_BETWEENNESS_H
+#define GRAPH_BETWEENNESS_H
+
+#include "graph.h"
+#include "csr.h"
+#include "heap.h"
+#include "parallel.h"
+#include "stats.h"
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+namespace short_paths {
+
+	class betweenness {
+	private:
+		struct distNode {
+			size_t   dist_;
+			uint32_t node_;
+		};
+		struct distNodeCompare {
+			bool operator() (const distNode& n1, const distNode& n2) const
+			{
+				return n1.dist_ < n2.dist_;
+			}
+		};
+
+		// per thread state of single source shortest paths.
+		struct workspace {
+			vector<size_t>   dist_;
+			vector<double>   sigma_;
+			vector<double>   delta_;
+			vector<uint32_t> order_;  // nodes in order of non-decreasing distance.
+			vector<bool>     settled_;
+			vector<double>   score_;
+			workspace(size_t n) : dist_(n, unreached()), sigma_(n, 0), delta_(n, 0), settled_(n, false), score_(n, 0)
+			{}
+		};
+		static size_t unreached() { return static_cast<size_t>(-1); }
+
+		const basicGraph::bGraph* graph_;
+		size_t                    samples_; // 0 for exact.
+		size_t                    nSources_;
+		vector<double>            score_;   // indexed by node id.
+
+		static void bfs(const basicGraph::csrGraph& out, uint32_t src, workspace& ws)
+		{
+			ws.dist_[src]  = 0;
+			ws.sigma_[src] = 1;
+			ws.order_.push_back(src);
+			for (size_t head = 0; head < ws.order_.size(); head++)
+			{
+				uint32_t u = ws.order_[head];
+				for (const uint32_t* w = out.begin(u); w != out.end(u); w++)
+				{
+					if (ws.dist_[*w] == unreached()) {
+						ws.dist_[*w] = ws.dist_[u] + 1;
+						ws.order_.push_back(*w);
+					}
+					if (ws.dist_[*w] == ws.dist_[u] + 1)
+						ws.sigma_[*w] += ws.sigma_[u];
+				}
+			}
+		}
+
+		// dijkstra with lazy deletion; nodes are settled in distance order.
+		static void dijkstra(const basicGraph::csrGraph& out, uint32_t src, workspace& ws)
+		{
+			Heap<distNode, distNodeCompare> PQ;
+			ws.dist_[src]  = 0;
+			ws.sigma_[src] = 1;
+			distNode qnode = { 0, src };
+			PQ.push(qnode);
+			while (PQ.pop(qnode))
+			{
+				uint32_t u = qnode.node_;
+				if (ws.settled_[u] || qnode.dist_ > ws.dist_[u])
+					continue;
+				ws.settled_[u] = true;
+				ws.order_.push_back(u);
+				for (size_t arc = out.offset(u); arc < out.offset(u + 1); arc++)
+				{
+					uint32_t w   = out.begin(u)[arc - out.offset(u)];
+					size_t   alt = ws.dist_[u] + out.weight(arc);
+					if (alt < ws.dist_[w]) {
+						ws.dist_[w]  = alt;
+						ws.sigma_[w] = ws.sigma_[u];
+						distNode next = { alt, w };
+						PQ.push(next);
+					}
+					else if (alt == ws.dist_[w] && !ws.settled_[w])
+						ws.sigma_[w] += ws.sigma_[u];
+				}
+			}
+		}
+
+		// dependency accumulation in reverse settle order, then clean up.
+		static void accumulate(const basicGraph::csrGraph& in, uint32_t src, workspace& ws)
+		{
+			STATS_ADD(NODES_SETTLED, ws.order_.size());
+			for (size_t i = ws.order_.size(); i-- > 0; )
+			{
+				uint32_t w = ws.order_[i];
+				double coeff = (1 + ws.delta_[w]) / ws.sigma_[w];
+				for (size_t arc = in.offset(w); arc < in.offset(w + 1); arc++)
+				{
+					uint32_t v = in.begin(w)[arc - in.offset(w)];
+					size_t   wt = in.hasWeights() ? in.weight(arc) : 1;
+					if (ws.dist_[v] != unreached() && ws.dist_[v] + wt == ws.dist_[w])
+						ws.delta_[v] += ws.sigma_[v] * coeff;
+				}
+				if (w != src)
+					ws.score_[w] += ws.delta_[w];
+			}
+			for (size_t i = 0; i < ws.order_.size(); i++)
+			{
+				uint32_t w = ws.order_[i];
+				ws.dist_[w]  = unreached();
+				ws.sigma_[w] = 0;
+				ws.delta_[w] = 0;
+				ws.settled_[w] = false;
+			}
+			ws.order_.clear();
+		}
+
+		bool weighted() const
+		{
+			set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter;
+			for (eiter = graph_->edgeBegin(); eiter != graph_->edgeEnd(); eiter++)
+				if ((*eiter)->hasWeight())
+					return true;
+			return false;
+		}
+	public:
+		betweenness(const basicGraph::bGraph* graph, size_t samples = 0) :
+			graph_(graph), samples_(samples), nSources_(0)
+		{}
+		void build()
+		{
+			size_t n = graph_->nNodes();
+			score_.assign(n, 0);
+			if (n == 0)
+				return;
+
+			bool isWeighted = weighted();
+			basicGraph::csrGraph out(graph_, false, isWeighted);
+			basicGraph::csrGraph in(graph_, true, isWeighted);
+
+			vector<uint32_t> sources(n);
+			for (size_t u = 0; u < n; u++)
+				sources[u] = static_cast<uint32_t>(u);
+			if (samples_ && samples_ < n)
+			{
+				mt19937 rng(20011001);
+				shuffle(sources.begin(), sources.end(), rng);
+				sources.resize(samples_);
+			}
+			nSources_ = sources.size();
+
+			vector<vector<double>> partial(parallel::nThreads());
+			parallel::for_chunks(0, sources.size(), [&](size_t lo, size_t hi, size_t chunk) {
+				workspace ws(n);
+				for (size_t i = lo; i < hi; i++)
+				{
+					if (isWeighted)
+						dijkstra(out, sources[i], ws);
+					else
+						bfs(out, sources[i], ws);
+					accumulate(in, sources[i], ws);
+				}
+				partial[chunk].swap(ws.score_);
+			}, 1);
+
+			double scale = static_cast<double>(n) / nSources_;
+			if (!graph_->directed())
+				scale /= 2; // every path was counted from both ends.
+			for (size_t c = 0; c < partial.size(); c++)
+				for (size_t u = 0; u < partial[c].size(); u++)
+					score_[u] += partial[c][u] * scale;
+		}
+
+		const vector<double>& scores() const { return score_; }
+		double score(const basicGraph::bNode* node) const { return score_[node->id()]; }
+		bool   exact() const { return nSources_ == score_.size(); }
+
+		// bound on error of normalized scores, holds with probability 1-p.
+		double errorBound(double p = 0.05) const
+		{
+			if (exact() || nSources_ == 0)
+				return 0;
+			return sqrt(log(2.0 * score_.size() / p) / (2.0 * nSources_));
+		}
+
+		void print(size_t k) const
+		{
+			size_t n = score_.size();
+			vector<uint32_t> ids(n);
+			for (size_t u = 0; u < n; u++)
+				ids[u] = static_cast<uint32_t>(u);
+			k = min(k, n);
+			const vector<double>& score = score_;
+			partial_sort(ids.begin(), ids.begin() + k, ids.end(), [&score](uint32_t a, uint32_t b) {
+				return score[a] != score[b] ? score[a] > score[b] : a < b;
+			});
+
+			double norm = n > 2 ? static_cast<double>(n - 1) * (n - 2) : 1;
+			if (!graph_->directed())
+				norm /= 2;
+			cout << "rank node betweenness normalized\n";
+			cout << "==== ==== =========== ==========\n";
+			for (size_t i = 0; i < k; i++)
+				cout << i + 1 << " " << graph_->node(ids[i])->name() << " "
+					<< score_[ids[i]] << " " << score_[ids[i]] / norm << "\n";
+			if (exact())
+				cout << "exact, " << nSources_ << " sources.\n";
+			else
+				cout << "sampled " << nSources_ << " sources, normalized error <= "
+					<< errorBound() << " with 95% confidence.\n";
+		}
+	};
+}
+
+#endif
@@ -11,34 +11,193 @@
 
 #include "dvector.h"
 #include "scc.h"
+#include "parallelScc.h"
+#include "cc.h"
+#include "reach.h"
+#include "pagerank.h"
+#include "betweenness.h"
+#include "triangles.h"
+#include "louvain.h"
+#include "kcore.h"
+#include "randomWalk.h"
+#include "hyperBall.h"
+#include "maxFlow.h"
 #include "dfs.h"
+#include "topoSort.h"
 #include "mst.h"
 #include "shortestPath.h"
+#include "stats.h"
+#include "footprint.h"
+#include "typedGraph.h"
+#include "properties.h"
+#include "query.h"
+#include "server.h"
 #include <iostream>
 #include <algorithm>
 #include <vector>
 #include <sstream>
-
-template <typename T>
-T dvector<T>::NULL_DATA = 0;
+#include <fstream>
 
 using namespace std;
 
+// sends queries to a running server and prints the answers.
+static int connect_and_query(int argc, char** argv)
+{
+#ifdef _WIN32
+	cerr << "Error: client mode needs Unix domain sockets.\n";
+	return 1;
+#else
+	if (argc < 3) {
+		cerr << "Error: no socket given.\n";
+		return 1;
+	}
+	service::client connection;
+	if (!connection.connect(argv[2]))
+		return 1;
+
+	// one query from the command line, else one per line of stdin.
+	vector<string> requests;
+	string request;
+	for (int i = 3; i < argc; i++)
+		request += (i > 3 ? " " : "") + string(argv[i]);
+	if (!request.empty())
+		requests.push_back(request);
+	else
+		while (getline(cin, request))
+			if (request.find_first_not_of(" \t\r") != string::npos)
+				requests.push_back(request);
+
+	bool allOk = true;
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		bool   ok = false;
+		string output, error;
+		if (!connection.request(requests[i], ok, output, error))
+			return 1;
+		cout << output;
+		cerr << error;
+		allOk = allOk && ok;
+	}
+	return allOk ? 0 : 2;
+#endif
+}
+
 int main(int argc, char** argv)
 {
 	if (argc < 2) {
 		cerr << "Error: no input graph given.\n";
 		return 1;
 	}
+
+	// client mode: bgaMain.exe --connect <socket> [<query>], queries from stdin if none given.
+	if (string(argv[1]) == "--connect")
+		return connect_and_query(argc, argv);
+
+	// batch mode: bgaMain.exe <graph> --batch <query_file> [--format json|tsv] [--out <file>]
+	// server mode: bgaMain.exe <graph> --serve <socket> [--workers <n>]
+	// any mode:    [--threads <n>] threads of the parallel engines.
+	string batchFile, outFile, format = "json", socketPath, threads;
+	size_t nWorkers = 0;
+	for (int i = 2; i < argc; i++)
+	{
+		string option = argv[i];
+		if (i + 1 >= argc || (option != "--batch" && option != "--format" && option != "--out" &&
+			option != "--serve" && option != "--workers" && option != "--threads")) {
+			cerr << "Error: option " << option << " not recognized.\n";
+			return 1;
+		}
+		string value = argv[++i];
+		if (option == "--batch")        batchFile  = value;
+		else if (option == "--format")  format     = value;
+		else if (option == "--out")     outFile    = value;
+		else if (option == "--serve")   socketPath = value;
+		else if (option == "--workers") nWorkers   = strtoul(value.c_str(), nullptr, 10);
+		else                            threads    = value;
+	}
+	if (!threads.empty() && !parallel::setThreads(strtoul(threads.c_str(), nullptr, 10))) {
+		cerr << "Error: invalid thread count " << threads << ".\n";
+		return 1;
+	}
+	if (format != "json" && format != "tsv") {
+		cerr << "Error: invalid format " << format << ". Options are\n";
+		cerr << "        json.\n";
+		cerr << "        tsv.\n";
+		return 1;
+	}
+
+	STATS_PHASE(LOAD);
 	basicGraph::bGraph* graph = basicGraph::bGraph::readBasicGraph(argv[1]);
+	STATS_END_PHASE();
 	if (!graph) {
 		cerr << "Error: graph could not be built.\n";
 		return 1;
 	}
+
+	if (!socketPath.empty())
+	{
+#ifdef _WIN32
+		cerr << "Error: server mode needs Unix domain sockets.\n";
+		delete graph;
+		return 1;
+#else
+		cout << "serving graph with " << graph->nNodes() << " nodes and " << graph->nEdges()
+			<< " edges on " << socketPath << ".\n";
+		cout.flush();
+		service::server daemon(graph, argv[1]); // owns graph from here on.
+		bool served = daemon.serve(socketPath, nWorkers);
+		if (served)
+			cout << "served " << daemon.nRequests() << " requests.\n";
+		return served ? 0 : 1;
+#endif
+	}
+
+	// node and edge properties from the sidecar file, if there is one.
+	properties::store props;
+	string            propsFile = properties::sidecar(argv[1]);
+	bool              hasProps  = ifstream(propsFile.c_str()) && props.load(propsFile, graph);
+
+	if (!batchFile.empty())
+	{
+		ifstream queries(batchFile.c_str());
+		if (!queries) {
+			cerr << "Error: could not open file " << batchFile << ".\n";
+			delete graph;
+			return 1;
+		}
+		ofstream file;
+		if (!outFile.empty()) {
+			file.open(outFile.c_str(), ios::binary);
+			if (!file) {
+				cerr << "Error: could not open file " << outFile << ".\n";
+				delete graph;
+				return 1;
+			}
+		}
+		query::batch runner(graph, format == "tsv" ? query::batch::TSV : query::batch::JSON_LINES, 0, &props);
+		bool written = runner.run(queries, outFile.empty() ? cout : file);
+		if (!written)
+			cerr << "Error: could not write results.\n";
+		else if (!outFile.empty())
+			cout << "answered " << runner.nQueries() << " queries (" << runner.nFailed() << " failed), results in "
+				<< outFile << ".\n";
+		delete graph;
+		return written ? 0 : 1;
+	}
+
 	cout << "created graph with " << graph->nNodes() << " nodes and " << graph->nEdges() << " edges.\n";
+	if (hasProps)
+		cout << "loaded properties from " << propsFile << ".\n";
 	cout << "type \'help' for more options\n";
 
+	reachability::grail* reachIndex = nullptr; // built on first query.
+	basicGraph::anyGraph typedGraph;           // built by typed, or on first typed path.
+	string               lastQuery;            // command the stats are of.
+	footprint::report    lastUsage;            // footprint of its result.
+	output::format       resultFormat = output::TEXT;
+	ofstream             resultFile;           // results go here when open, else to cout.
+
 	while (true) {
+		STATS_END_PHASE();
 		string line, token;
 		cout << ">> ";
 		getline(cin, line);
@@ -54,112 +213,427 @@ int main(int argc, char** argv)
 		string choice = tokens[0];
 
 		transform(choice.begin(), choice.end(), choice.begin(), ::tolower);
+		if (choice != "stats" && choice != "help" && choice != "memory")
+		{
+			// counters, timers and heap peak describe the last command only.
+			stats::reset();
+			footprint::reset_peak();
+			lastUsage.clear();
+			lastQuery = line;
+			STATS_PHASE(BUILD);
+		}
 		if (choice == "help" ) 
 		{
 			cout << " help\n";
 			cout << " print\n";
 			cout << " transpose\n";
 			cout << " scc     [<node>]\n";
+			cout << " pscc    [<node>]\n";               // parallel scc with phase timings
+			cout << " cc      [<node>]\n";               // (weakly) connected components
+			cout << " reach   <node1> <node2>|save <file>|load <file>\n"; // reachability index query
+			cout << " pagerank [<top_k>] [float|double]\n";  // top ranked nodes
+			cout << " betweenness [<top_k>] [exact|sample <n>]\n"; // top central nodes
+			cout << " triangles [<top_k>]\n";    // triangle count and clustering coefficients
+			cout << " community [<node>]\n";     // louvain communities and modularity
+			cout << " kcore   [<k>] [serial|parallel]\n"; // core numbers, or the k-core subgraph
+			cout << " walk    <file> [<length> [<walks_per_node> [<p> <q>]]] [uniform]\n"; // node2vec walks to file
+			cout << " hyperball [<top_k>] [<log2_registers>]\n"; // neighborhood function, diameter, harmonic centrality
+			cout << " maxflow <source_node> <sink_node>\n"; // max flow value and min cut edges
 			cout << " search  <root_node>\n";    // dfs search tree
 			cout << " sort \n";                  // levelize or topological sort
 			cout << " mst     [prim|kruskal]\n"; // minimal spanning tree
-			cout << " path    <start_node> [<end_node>]\n";  // Path from source to one or all vertices
+			cout << " path    <start_node> [<end_node>] [weight <edge_property>]\n";  // Path from source to one or all vertices
+			cout << " props   [load <file>|<node>]\n"; // node and edge property columns
+			cout << " typed   [auto|uint32|uint64|float|double|unweighted]|path <start_node> [<end_node>]\n"; // compile-time typed graph
+			cout << " output  text|csv|binary [<file>]\n"; // format and file of print, scc, cc, search, sort, mst and path
+			cout << " stats   [reset]\n";            // work counters and phase timings of the last command
+			cout << " memory  [compact]\n";          // footprint of graph and last result, heap peak
 			cout << " quit\n";
 		} 
 		else if (choice == "print") 
 		{
-			graph->print();
-			cout << "\n";
+			STATS_PHASE(PRINT);
+			output::writer out(resultFile.is_open() ? resultFile : cout, resultFormat);
+			graph->print(out);
+			if (out.text())
+				out << "\n";
 		}
 		else if (choice == "transpose")
 		{
 			transpose reverse(false);
 			const basicGraph::bGraph* new_graph = reverse.build(graph);
+			STATS_PHASE(PRINT);
 			new_graph->print();
 			delete new_graph;
 		}
-		else if (choice == "scc")
+		else if (query::supported(choice))
+		{
+			query::run(graph, tokens, resultFile.is_open() ? resultFile : cout, cerr, resultFormat, &lastUsage, &props);
+		}
+		else if (choice == "output")
 		{
-			SCC::kosaraju sccBuilder(graph);
+			output::format fmt = output::TEXT;
+			if (tokens.size() < 2 || !output::parse_format(tokens[1], fmt)) {
+				cerr << "Error: invalid option. Options are\n";
+				cerr << "        text [<file>].\n";
+				cerr << "        csv [<file>].\n";
+				cerr << "        binary <file>.\n";
+				continue;
+			}
+			if (fmt == output::BINARY && tokens.size() < 3) {
+				cerr << "Error: supply a file for binary output and try again.\n";
+				continue;
+			}
+			if (resultFile.is_open())
+				resultFile.close();
+			resultFile.clear();
+			if (tokens.size() > 2) {
+				resultFile.open(tokens[2].c_str(), ios::binary);
+				if (!resultFile) {
+					cerr << "Error: could not open file " << tokens[2] << ".\n";
+					resultFormat = output::TEXT;
+					continue;
+				}
+			}
+			resultFormat = fmt;
+		}
+		else if (choice == "pscc")
+		{
+			SCC::multistep sccBuilder(graph);
 			sccBuilder.build();
-			sccBuilder.print();
+			STATS_PHASE(PRINT);
+			if (tokens.size() < 2)
+			{
+				sccBuilder.print();
+				sccBuilder.print_timings();
+				continue;
+			}
+			const basicGraph::bNode* node = graph->findNode(tokens[1]);
+			if (!node)
+				cerr << "Error: node " << tokens[1] << "not found in the graph.\n";
+			else
+				sccBuilder.print_component(sccBuilder.component(node));
 		}
-		else if (choice == "search") 
+		else if (choice == "reach")
 		{
-			if (tokens.size() < 2) {
-				cerr << "Error: supply search node and try again.\n";
+			if (tokens.size() < 3) {
+				cerr << "Error: supply two nodes, or save|load and a file name.\n";
 				continue;
 			}
-			string node = tokens[1];
-			const basicGraph::bNode* src = graph->findNode(node);
-			if (!src) {
-				cerr << "Error: node " << node << "not found in the graph.\n";
+			if (tokens[1] == "load")
+			{
+				reachability::grail* index = new reachability::grail();
+				if (index->load(tokens[2], graph)) {
+					delete reachIndex;
+					reachIndex = index;
+					reachIndex->print();
+				}
+				else
+					delete index;
+				continue;
 			}
-			else {
-				DFS traverse(graph);
-				traverse.search(src);
-		    }
+			if (!reachIndex) {
+				reachIndex = new reachability::grail();
+				reachIndex->build(graph);
+			}
+			if (tokens[1] == "save")
+			{
+				if (reachIndex->save(tokens[2]))
+					reachIndex->print();
+				continue;
+			}
+			const basicGraph::bNode* src = graph->findNode(tokens[1]);
+			const basicGraph::bNode* dst = graph->findNode(tokens[2]);
+			if (!src || !dst) {
+				cerr << "Error: node " << (src ? tokens[2] : tokens[1]) << "not found in the graph.\n";
+				continue;
+			}
+			cout << src->name() << (reachIndex->reachable(src, dst) ? " reaches " : " does not reach ")
+				<< dst->name() << ".\n";
+		}
+		else if (choice == "props")
+		{
+			if (tokens.size() > 1 && tokens[1] == "load")
+			{
+				string file = tokens.size() > 2 ? tokens[2] : propsFile;
+				if (props.load(file, graph))
+					props.print();
+				continue;
+			}
+			if (tokens.size() > 1)
+			{
+				const basicGraph::bNode* node = graph->findNode(tokens[1]);
+				if (!node) {
+					cerr << "Error: node " << tokens[1] << "not found in the graph.\n";
+					continue;
+				}
+				props.print_node(node);
+				continue;
+			}
+			props.print();
 		}
-		else if (choice == "sort") 
+		else if (choice == "typed")
 		{
-			DFS traverse(graph);
-			traverse.topological_sort();
+			if (tokens.size() > 1 && tokens[1] == "path")
+			{
+				if (tokens.size() < 3) {
+					cerr << "Error: supply search node and try again.\n";
+					continue;
+				}
+				const basicGraph::bNode* src = graph->findNode(tokens[2]);
+				const basicGraph::bNode* dst = tokens.size() > 3 ? graph->findNode(tokens[3]) : nullptr;
+				if (!src || (tokens.size() > 3 && !dst)) {
+					cerr << "Error: node " << (src ? tokens[3] : tokens[2]) << "not found in the graph.\n";
+					continue;
+				}
+				if (typedGraph.empty())
+					typedGraph.build(graph);
+				typedGraph.print_paths(src, dst);
+				continue;
+			}
+			string weights = tokens.size() > 1 ? tokens[1] : "auto";
+			if (!typedGraph.build(graph, weights)) {
+				cerr << "Error: invalid option " << weights << ". Options are\n";
+				cerr << "        auto.\n";
+				cerr << "        uint32.\n";
+				cerr << "        uint64.\n";
+				cerr << "        float.\n";
+				cerr << "        double.\n";
+				cerr << "        unweighted.\n";
+				cerr << "        path.\n";
+				continue;
+			}
+			footprint::report usage;
+			typedGraph.memory(usage);
+			STATS_PHASE(PRINT);
+			cout << "built " << typedGraph.kind() << " graph with " << typedGraph.nArcs() << " arcs in "
+				<< usage.total() << " bytes.\n";
 		}
-		else if (choice == "mst")
+		else if (choice == "betweenness")
 		{
-			string algo = tokens.size() < 2 ? "kruskal" : tokens[1];
-			if (algo == "kruskal")
+			size_t top_k = tokens.size() > 1 ? strtoul(tokens[1].c_str(), nullptr, 10) : 10;
+			string mode = tokens.size() > 2 ? tokens[2] : "exact";
+			size_t samples = 0;
+			if (mode == "sample")
 			{
-				MST::kruskal mst(graph);
-				mst.build();
-				mst.print();
+				samples = tokens.size() > 3 ? strtoul(tokens[3].c_str(), nullptr, 10) : 0;
+				if (samples == 0) {
+					cerr << "Error: number of samples must be positive.\n";
+					continue;
+				}
+			}
+			else if (mode != "exact") {
+				cerr << "Error: invalid option " << mode << ". Options are\n";
+				cerr << "        exact.\n";
+				cerr << "        sample <n>.\n";
+				continue;
 			}
-			else if (algo == "prim")
+			short_paths::betweenness central(graph, samples);
+			central.build();
+			STATS_PHASE(PRINT);
+			central.print(top_k);
+		}
+		else if (choice == "triangles")
+		{
+			size_t top_k = tokens.size() > 1 ? strtoul(tokens[1].c_str(), nullptr, 10) : 10;
+			triangles::triangleCount count(graph);
+			count.build();
+			STATS_PHASE(PRINT);
+			count.print(top_k);
+		}
+		else if (choice == "community")
+		{
+			community::louvain communities(graph);
+			communities.build();
+			STATS_PHASE(PRINT);
+			if (tokens.size() < 2)
 			{
-				MST::prim mst(graph);
-				mst.build();
-				mst.print();
+				communities.print();
+				continue;
 			}
+			const basicGraph::bNode* node = graph->findNode(tokens[1]);
+			if (!node)
+				cerr << "Error: node " << tokens[1] << "not found in the graph.\n";
 			else {
-				cerr << "Error: invalid option " << algo << ". Options are\n";
-				cerr << "        prim.\n";
-				cerr << "        kruskal.\n";
+				communities.print_community(communities.community(node));
+				communities.print_summary();
 			}
 		}
-		else if (choice == "path")
+		else if (choice == "kcore")
+		{
+			bool   parallelPeel = false;
+			string k;
+			for (size_t i = 1; i < tokens.size(); i++)
+			{
+				if (tokens[i] == "parallel" || tokens[i] == "serial")
+					parallelPeel = tokens[i] == "parallel";
+				else
+					k = tokens[i];
+			}
+			if (!k.empty() && k.find_first_not_of("0123456789") != string::npos) {
+				cerr << "Error: invalid option " << k << ". Options are\n";
+				cerr << "        <k>.\n";
+				cerr << "        serial.\n";
+				cerr << "        parallel.\n";
+				continue;
+			}
+			cores::kcore coreBuilder(graph);
+			coreBuilder.build(parallelPeel);
+			if (k.empty())
+			{
+				coreBuilder.print();
+				continue;
+			}
+			basicGraph::bGraph* core = coreBuilder.extract(static_cast<uint32_t>(strtoul(k.c_str(), nullptr, 10)));
+			STATS_PHASE(PRINT);
+			cout << k << "-core has " << core->nNodes() << " nodes and " << core->nEdges() << " edges.\n";
+			core->print();
+			delete core;
+		}
+		else if (choice == "walk")
 		{
 			if (tokens.size() < 2) {
-				cerr << "Error: supply search node and try again.\n";
+				cerr << "Error: no output file given.\n";
 				continue;
 			}
-			string node1 = tokens[1];
-			string node2 = tokens.size() > 2 ? tokens[2] : "" ;
-			const basicGraph::bNode* src = graph->findNode(node1);
-			if (!src) 
+			walks::walkOptions options;
+			vector<string> numbers;
+			for (size_t i = 2; i < tokens.size(); i++)
 			{
-				cerr << "Error: node " << node1 << "not found in the graph.\n";
+				if (tokens[i] == "uniform")
+					options.weighted_ = false;
+				else
+					numbers.push_back(tokens[i]);
+			}
+			if (numbers.size() > 0) options.length_       = strtoul(numbers[0].c_str(), nullptr, 10);
+			if (numbers.size() > 1) options.walksPerNode_ = strtoul(numbers[1].c_str(), nullptr, 10);
+			if (numbers.size() > 2) options.p_            = strtod(numbers[2].c_str(), nullptr);
+			if (numbers.size() > 3) options.q_            = strtod(numbers[3].c_str(), nullptr);
+			if (numbers.size() == 3 || numbers.size() > 4 || options.p_ <= 0 || options.q_ <= 0) {
+				cerr << "Error: invalid walk options. p and q must be given together and be positive.\n";
 				continue;
 			}
-			const basicGraph::bNode* dst = node2.length() ? graph->findNode(node2) : nullptr;
-			if (node2.size() && !dst)
+			walks::randomWalk walker(graph, options);
+			if (walker.write(tokens[1]))
+				cout << "wrote " << graph->nNodes() * options.walksPerNode_ << (walker.weighted() ? " weighted" : " uniform")
+					<< " walks with " << walker.steps() << " steps to " << tokens[1] << ".\n";
+		}
+		else if (choice == "hyperball")
+		{
+			size_t top_k = tokens.size() > 1 ? strtoul(tokens[1].c_str(), nullptr, 10) : 10;
+			size_t log2m = tokens.size() > 2 ? strtoul(tokens[2].c_str(), nullptr, 10) : 6;
+			short_paths::hyperBall balls(graph, log2m);
+			balls.build();
+			STATS_PHASE(PRINT);
+			balls.print(top_k);
+		}
+		else if (choice == "maxflow")
+		{
+			if (tokens.size() < 3) {
+				cerr << "Error: source and sink nodes are required.\n";
+				continue;
+			}
+			const basicGraph::bNode* src = graph->findNode(tokens[1]);
+			const basicGraph::bNode* dst = graph->findNode(tokens[2]);
+			if (!src || !dst) {
+				cerr << "Error: node " << (src ? tokens[2] : tokens[1]) << "not found in the graph.\n";
+				continue;
+			}
+			if (src == dst) {
+				cerr << "Error: source and sink must be different nodes.\n";
+				continue;
+			}
+			flow::pushRelabel maxflow(graph, src, dst);
+			maxflow.build();
+			STATS_PHASE(PRINT);
+			maxflow.print();
+		}
+		else if (choice == "stats")
+		{
+			if (!stats::enabled()) {
+				cerr << "Error: statistics are compiled out, rebuild without BGA_NO_STATS.\n";
+				continue;
+			}
+			if (tokens.size() > 1 && tokens[1] == "reset") {
+				stats::reset(true);
+				lastQuery.clear();
+				continue;
+			}
+			if (tokens.size() > 1) {
+				cerr << "Error: invalid option " << tokens[1] << ". Options are\n";
+				cerr << "        reset.\n";
+				continue;
+			}
+			if (!lastQuery.empty())
+				cout << "stats of '" << lastQuery << "'\n";
+			stats::print();
+		}
+		else if (choice == "memory")
+		{
+			if (tokens.size() > 1 && tokens[1] == "compact")
 			{
-				cerr << "Error: node " << node2 << "not found in the graph.\n";
-				cerr << "       will use single source path algorithm.\n";
+				footprint::report before, after;
+				size_t resident = footprint::resident_bytes();
+				graph->memory(before);
+				graph->compact();
+				graph->memory(after);
+				cout << "compacted graph from " << before.total() << " to " << after.total() << " bytes";
+				if (resident)
+					cout << ", resident " << resident << " to " << footprint::resident_bytes() << " bytes";
+				cout << ".\n";
+				continue;
 			}
-
-			if ( dst == nullptr ) 
+			if (tokens.size() > 1) {
+				cerr << "Error: invalid option " << tokens[1] << ". Options are\n";
+				cerr << "        compact.\n";
+				continue;
+			}
+			footprint::report usage;
+			graph->memory(usage);
+			cout << "graph\n";
+			usage.print(cout);
+			if (!props.empty()) {
+				footprint::report columns;
+				props.memory(columns);
+				cout << "properties\n";
+				columns.print(cout);
+			}
+			if (!lastUsage.empty()) {
+				cout << "result of '" << lastQuery << "'\n";
+				lastUsage.print(cout);
+			}
+			if (footprint::tracking()) {
+				cout << "heap in use " << footprint::live() << " bytes";
+				if (!lastQuery.empty())
+					cout << ", peak during '" << lastQuery << "' " << footprint::peak_growth() << " bytes above its start";
+				cout << ".\n";
+			}
+			size_t resident = footprint::resident_bytes();
+			if (resident)
+				cout << "resident " << resident << " bytes.\n";
+		}
+		else if (choice == "pagerank")
+		{
+			size_t top_k = tokens.size() > 1 ? strtoul(tokens[1].c_str(), nullptr, 10) : 10;
+			string precision = tokens.size() > 2 ? tokens[2] : "double";
+			if (precision == "float")
 			{
-				// path to all nodes from source
-				short_paths::dijkstra single_source_path(src, graph);
-				single_source_path.build();
-				single_source_path.print();
-			} 
-			else
+				ranking::pagerank<float> ranks(graph);
+				ranks.build();
+				STATS_PHASE(PRINT);
+				ranks.print(top_k);
+			}
+			else if (precision == "double")
 			{
-				// a_star search for source and destination.
-				short_paths::aStar src_dst_path(src, graph);
-				src_dst_path.build(dst);
-				src_dst_path.print(dst);
+				ranking::pagerank<double> ranks(graph);
+				ranks.build();
+				STATS_PHASE(PRINT);
+				ranks.print(top_k);
+			}
+			else {
+				cerr << "Error: invalid option " << precision << ". Options are\n";
+				cerr << "        float.\n";
+				cerr << "        double.\n";
 			}
 		}
 		else if (choice == "quit" || choice == "exit")
@@ -173,6 +647,7 @@ int main(int argc, char** argv)
 		}
 	}
 
+	delete reachIndex;
 	delete graph;
 	return 0;
 }
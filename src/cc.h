@@ -0,0 +1,249 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Connected Components:
+//      Two nodes are in the same connected component if there is a path
+// between them, ignoring edge direction. For directed graphs these are
+// the weakly connected components.
+//
+// Afforest algorithm:
+//      Concurrent union-find. comp[v] points to a node with smaller or
+// equal id, so every tree has its smallest node as root. Linking two
+// trees hooks the larger root under the smaller one with a compare and
+// swap; a failed swap means someone else linked first, and it retries
+// from the new roots. No locks are taken.
+//
+//   1. Neighbor sampling: link each node to its first two neighbors
+//      only. This is usually enough to form the giant component.
+//   2. Find the most frequent component c from a random sample of nodes.
+//   3. Link all remaining edges, skipping nodes already in c. Their
+//      edges can only join c, and their neighbors outside c link to
+//      them through in-edges.
+//   4. Compress all paths so comp[v] is the root of v.
+//
+// Reference: Sutton, Ben-Nun, Barak, "Optimizing Parallel Graph
+//            Connectivity Computation via Subgraph Sampling", IPDPS 2018.
+//            Shiloach, Vishkin, "An O(log n) Parallel Connectivity
+//            Algorithm", 1982.
+
+#ifndef GRAPH_CC_H
+#define GRAPH_CC_H
+
+#include "graph.h"
+#include "csr.h"
+#include "parallel.h"
+#include "stats.h"
+#include <atomic>
+#include <memory>
+#include <random>
+#include <map>
+
+using namespace std;
+
+namespace CC {
+
+	class afforest {
+	private:
+		enum { NEIGHBOR_ROUNDS = 2, SAMPLES = 1024 };
+
+		const basicGraph::bGraph*      graph_;
+		unique_ptr<atomic<uint32_t>[]> comp_;     // union-find parent while building.
+		vector<uint32_t>               compId_;   // dense component id, indexed by node id.
+		vector<size_t>                 sizes_;    // nodes in each component.
+
+		void link(uint32_t u, uint32_t v)
+		{
+			STATS_INC(UNION_CALLS);
+			uint32_t p1 = comp_[u].load(memory_order_relaxed);
+			uint32_t p2 = comp_[v].load(memory_order_relaxed);
+			while (p1 != p2)
+			{
+				uint32_t high   = max(p1, p2);
+				uint32_t low    = min(p1, p2);
+				uint32_t pHigh  = comp_[high].load(memory_order_relaxed);
+				if (pHigh == low)
+					break;
+				if (pHigh == high && comp_[high].compare_exchange_strong(pHigh, low))
+					break;
+				p1 = comp_[comp_[high].load(memory_order_relaxed)].load(memory_order_relaxed);
+				p2 = comp_[low].load(memory_order_relaxed);
+			}
+		}
+
+		void compress(size_t n)
+		{
+			parallel::parallel_for(0, n, [&](size_t u) {
+				uint32_t p = comp_[u].load(memory_order_relaxed);
+				while (p != comp_[p].load(memory_order_relaxed))
+				{
+					p = comp_[p].load(memory_order_relaxed);
+					comp_[u].store(p, memory_order_relaxed);
+				}
+			});
+		}
+
+		uint32_t most_frequent(size_t n)
+		{
+			map<uint32_t, size_t> counts;
+			mt19937 rng(27491095);
+			uniform_int_distribution<size_t> pick(0, n - 1);
+			for (size_t i = 0; i < SAMPLES; i++)
+				counts[comp_[pick(rng)].load(memory_order_relaxed)]++;
+
+			map<uint32_t, size_t>::iterator best = counts.begin();
+			for (map<uint32_t, size_t>::iterator it = counts.begin(); it != counts.end(); it++)
+				if (it->second > best->second)
+					best = it;
+			return best->first;
+		}
+	public:
+		afforest(const basicGraph::bGraph* graph) : graph_(graph)
+		{}
+		void build()
+		{
+			size_t n = graph_->nNodes();
+			compId_.clear();
+			sizes_.clear();
+			if (n == 0)
+				return;
+
+			basicGraph::csrGraph fwd(graph_);
+			unique_ptr<basicGraph::csrGraph> bwd(graph_->directed() ? new basicGraph::csrGraph(graph_, true) : nullptr);
+
+			comp_.reset(new atomic<uint32_t>[n]);
+			parallel::parallel_for(0, n, [&](size_t u) { comp_[u].store(static_cast<uint32_t>(u), memory_order_relaxed); });
+
+			for (size_t r = 0; r < NEIGHBOR_ROUNDS; r++)
+			{
+				parallel::parallel_for(0, n, [&](size_t u) {
+					if (r < fwd.degree(u))
+						link(static_cast<uint32_t>(u), fwd.begin(u)[r]);
+				});
+				compress(n);
+			}
+
+			uint32_t c = most_frequent(n);
+			parallel::parallel_for(0, n, [&](size_t u) {
+				if (comp_[u].load(memory_order_relaxed) == c)
+					return;
+				for (const uint32_t* w = fwd.begin(u) + min<size_t>(NEIGHBOR_ROUNDS, fwd.degree(u)); w != fwd.end(u); w++)
+					link(static_cast<uint32_t>(u), *w);
+				if (bwd)
+					for (const uint32_t* w = bwd->begin(u); w != bwd->end(u); w++)
+						link(static_cast<uint32_t>(u), *w);
+			}, 256);
+			compress(n);
+
+			// roots are the smallest node of each component; number them densely.
+			compId_.resize(n);
+			for (size_t u = 0; u < n; u++)
+			{
+				uint32_t root = comp_[u].load(memory_order_relaxed);
+				if (root == u) {
+					compId_[u] = static_cast<uint32_t>(sizes_.size());
+					sizes_.push_back(0);
+				}
+				else
+					compId_[u] = compId_[root];
+				sizes_[compId_[u]]++;
+			}
+			comp_.reset();
+			return;
+		}
+
+		size_t nComponents() const { return sizes_.size(); }
+		uint32_t component(const basicGraph::bNode* node) const { return compId_[node->id()]; }
+		const vector<uint32_t>& componentIds() const { return compId_; }
+		const vector<size_t>&   sizes()        const { return sizes_;  }
+		// bytes of the component ids and sizes, see footprint.h.
+		void memory(footprint::report& usage) const
+		{
+			usage.add("component_ids", compId_.size(), footprint::vector_bytes(compId_));
+			usage.add("sizes",         sizes_.size(),  footprint::vector_bytes(sizes_));
+		}
+
+		// number of components of each size.
+		map<size_t, size_t> histogram() const
+		{
+			map<size_t, size_t> hist;
+			for (size_t c = 0; c < sizes_.size(); c++)
+				hist[sizes_[c]]++;
+			return hist;
+		}
+
+		void print_component(uint32_t comp, ostream& out = cout) const
+		{
+			output::writer writer(out);
+			writer.header("component,node");
+			print_component(comp, writer);
+		}
+		// in csv and binary a record (component, node) per member.
+		void print_component(uint32_t comp, output::writer& out) const
+		{
+			if (out.text())
+				out << "CC Group " << comp << " : ";
+			for (size_t u = 0; u < compId_.size(); u++)
+			{
+				if (compId_[u] != comp)
+					continue;
+				if (out.text())
+					out << graph_->node(u)->name() << ' ';
+				else
+					out.field(comp).field(graph_->node(u)->name()).end_record();
+			}
+			if (out.text())
+				out << '\n';
+		}
+		void print(ostream& out = cout) const
+		{
+			output::writer writer(out);
+			print(writer);
+		}
+		// csv and binary leave out the histogram, which follows from the records.
+		void print(output::writer& out) const
+		{
+			// group members by component in one pass.
+			vector<size_t> offsets(sizes_.size() + 1, 0);
+			for (size_t c = 0; c < sizes_.size(); c++)
+				offsets[c + 1] = offsets[c] + sizes_[c];
+			vector<uint32_t> members(compId_.size());
+			vector<size_t>   fill(offsets.begin(), offsets.end() - 1);
+			for (size_t u = 0; u < compId_.size(); u++)
+				members[fill[compId_[u]]++] = static_cast<uint32_t>(u);
+
+			out.header("component,node");
+			for (size_t c = 0; c < sizes_.size(); c++)
+			{
+				if (!out.text()) {
+					for (size_t i = offsets[c]; i < offsets[c + 1]; i++)
+						out.field(c).field(graph_->node(members[i])->name()).end_record();
+					continue;
+				}
+				out << "CC Group " << c << " : ";
+				for (size_t i = offsets[c]; i < offsets[c + 1]; i++)
+					out << graph_->node(members[i])->name() << ' ';
+				out << '\n';
+			}
+			if (out.text())
+				print_histogram(out);
+		}
+		void print_histogram(ostream& out = cout) const
+		{
+			output::writer writer(out);
+			print_histogram(writer);
+		}
+		void print_histogram(output::writer& out) const
+		{
+			map<size_t, size_t> hist = histogram();
+			out << "size components\n";
+			out << "==== ==========\n";
+			for (map<size_t, size_t>::iterator it = hist.begin(); it != hist.end(); it++)
+				out << it->first << " " << it->second << "\n";
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Compressed Sparse Row (CSR):
+//      Read-only snapshot of the adjacency of a bGraph over dense node ids.
+// Neighbors of node u are targets_[offsets_[u], offsets_[u+1]), stored
+// contiguously for all nodes. It is the layout used by the multi-core
+// engines, which scan adjacency far more often than they change it.
+//
+// Undirected edges appear in the adjacency of both end nodes. Transposed
+// snapshot of a directed graph holds in-edges (v, u) for every (u, v).
+//
+// Reference: https://en.wikipedia.org/wiki/Sparse_matrix#Compressed_sparse_row_(CSR,_CRS_or_Yale_format)
+
+#ifndef GRAPH_CSR_H
+#define GRAPH_CSR_H
+
+#include "graph.h"
+#include "parallel.h"
+#include <stdint.h>
+
+using namespace std;
+
+namespace basicGraph {
+
+	class csrGraph {
+	private:
+		vector<size_t>   offsets_; // nNodes()+1 entries.
+		vector<uint32_t> targets_; // neighbor node ids.
+		vector<size_t>   weights_; // edge weights parallel to targets_, if requested.
+
+		void add(size_t from, size_t to, const bEdge* edge, vector<size_t>& fill, bool withWeights)
+		{
+			size_t slot = fill[from]++;
+			targets_[slot] = static_cast<uint32_t>(to);
+			if (withWeights)
+				weights_[slot] = edge->hasWeight() ?
+					dynamic_cast<const bWeightedEdge*>(edge)->weight() : 1;
+		}
+	public:
+		csrGraph(const bGraph* graph, bool transposed = false, bool withWeights = false)
+			: offsets_(graph->nNodes() + 1, 0)
+		{
+			bool reverse = transposed && graph->directed();
+
+			// count degrees, then offsets are their prefix sums.
+			set<const bEdge*, edgeCompare>::iterator eiter;
+			for (eiter = graph->edgeBegin(); eiter != graph->edgeEnd(); eiter++)
+			{
+				const bNode* from = reverse ? (*eiter)->n2() : (*eiter)->n1();
+				const bNode* to   = reverse ? (*eiter)->n1() : (*eiter)->n2();
+				offsets_[from->id()]++;
+				if (!graph->directed() && from != to)
+					offsets_[to->id()]++;
+			}
+			offsets_.back() = parallel::exclusive_scan(offsets_.data(), offsets_.data(), graph->nNodes(),
+				size_t(0), [](size_t a, size_t b) { return a + b; });
+
+			// fill neighbors
+			targets_.resize(offsets_.back());
+			if (withWeights)
+				weights_.resize(offsets_.back());
+			vector<size_t> fill(offsets_.begin(), offsets_.end() - 1);
+			for (eiter = graph->edgeBegin(); eiter != graph->edgeEnd(); eiter++)
+			{
+				const bNode* from = reverse ? (*eiter)->n2() : (*eiter)->n1();
+				const bNode* to   = reverse ? (*eiter)->n1() : (*eiter)->n2();
+				add(from->id(), to->id(), *eiter, fill, withWeights);
+				if (!graph->directed() && from != to)
+					add(to->id(), from->id(), *eiter, fill, withWeights);
+			}
+		}
+
+		size_t nNodes() const { return offsets_.size() - 1; }
+		size_t nArcs()  const { return targets_.size(); }
+		size_t degree(size_t u) const { return offsets_[u + 1] - offsets_[u]; }
+
+		// neighbor access, valid for the life time of the snapshot.
+		const uint32_t* begin(size_t u) const { return targets_.data() + offsets_[u]; }
+		const uint32_t* end(size_t u)   const { return targets_.data() + offsets_[u + 1]; }
+		size_t          offset(size_t u) const { return offsets_[u]; }
+		size_t          weight(size_t arc) const { return weights_[arc]; }
+		bool            hasWeights() const { return !weights_.empty() || targets_.empty(); }
+	};
+}
+
+#endif
@@ -5,9 +5,19 @@
 ///////////////////////////////////////////////////////////////////
 //
 // Generic dvector class for efficiency.
+//
+// The first N elements live inside the object, so a short vector needs no
+// heap block at all; beyond N they move to the heap, which grows by
+// VECTOR_GROWTH_FACTOR. Size and capacity are 32 bit. Elements are
+// constructed, moved and destroyed in place, and the vector itself can be
+// moved (stealing a heap block, or moving the inline elements).
 
 #include <assert.h>
-#include <stdlib.h>     /* malloc, free, rand */
+#include <stdlib.h>
+#include <stdint.h>
+#include <new>
+#include <utility>
+#include <type_traits>
 
 #pragma once
 
@@ -15,151 +25,250 @@
 // Ref: https://stackoverflow.com/questions/5232198/about-vectors-growth
 #define VECTOR_GROWTH_FACTOR 1.5
 
-template <class T>
+template <class T, unsigned N = 0>
 class dvector {
-	typedef size_t Index;
+	typedef uint32_t Index;
 protected:
-	T* _m_data;
-	size_t  _sz;
-	size_t  _capacity;
-	static T NULL_DATA;
+	T*        _m_data;
+	uint32_t  _sz;
+	uint32_t  _capacity;
+	typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type _inline[N ? N : 1];
+
+	T*   inline_data()       { return reinterpret_cast<T*>(_inline); }
+	bool is_inline()   const { return _m_data == reinterpret_cast<const T*>(_inline); }
 
+	// moves the elements to a block of capacity (inline if it fits).
+	void reallocate(size_t capacity)
+	{
+		assert(capacity >= _sz && capacity <= UINT32_MAX);
+		T* data = capacity <= N ? inline_data() : static_cast<T*>(::operator new(capacity * sizeof(T)));
+		if (data == _m_data)
+			return;
+		for (Index i = 0; i < _sz; i++)
+		{
+			new (data + i) T(std::move(_m_data[i]));
+			_m_data[i].~T();
+		}
+		if (!is_inline())
+			::operator delete(_m_data);
+		_m_data = data;
+		_capacity = static_cast<uint32_t>(capacity <= N ? N : capacity);
+	}
 	void stretch_capacity()
 	{
-		_capacity = static_cast<size_t>(VECTOR_GROWTH_FACTOR * _capacity);
-		_m_data = static_cast<T*>(realloc(_m_data, _capacity));
-		assert(_m_data);
+		size_t capacity = static_cast<size_t>(VECTOR_GROWTH_FACTOR * _capacity);
+		if (capacity < VECTOR_INIT_SIZE)
+			capacity = VECTOR_INIT_SIZE;
+		if (capacity > UINT32_MAX)
+			capacity = UINT32_MAX;
+		assert(capacity > _capacity);
+		reallocate(capacity);
 	}
-	// move data values from 'index' to end by n away from start.
-	void move_right(Index index, size_t n)
+	void destroy()
 	{
-		if (index < 0 || index >= _sz) return; // bad index
-		while (_sz + n >= _capacity)
-			stretch_capacity();
-		for (Index i = _sz + n - 1; i > index + n - 1; i--)
-			_m_data[i] = _m_data[i - 1];
-		_sz = _sz + n;
+		for (Index i = 0; i < _sz; i++)
+			_m_data[i].~T();
+		_sz = 0;
 	}
-	// move data values from 'index' to end by n towards start.
-	void move_left(Index index, size_t n)
+	void release()
 	{
-		if (index < 0 || index >= _sz) return; // bad index
-		if (index + n >= _sz) {
-			_sz = index;
+		destroy();
+		if (!is_inline())
+			::operator delete(_m_data);
+		_m_data = inline_data();
+		_capacity = N;
+	}
+	// takes the elements of other, leaving it empty.
+	void take(dvector& other)
+	{
+		if (!other.is_inline()) {
+			_m_data = other._m_data;
+			_sz = other._sz;
+			_capacity = other._capacity;
+			other._m_data = other.inline_data();
+			other._sz = 0;
+			other._capacity = N;
 			return;
 		}
-		for (Index i = index; i < _sz; i++)
-			_m_data[i] = _m_data[i + n];
-		_sz = _sz - n;
+		for (Index i = 0; i < other._sz; i++)
+			new (_m_data + i) T(std::move(other._m_data[i]));
+		_sz = other._sz;
+		other.destroy();
 	}
 public:
+	typedef T*       iterator;
+	typedef const T* const_iterator;
+
 	// These selected vector methods are inspired from STL C++ vector template
 	// default constructor
-	dvector(size_t max_sz = VECTOR_INIT_SIZE)
+	dvector() : _m_data(inline_data()), _sz(0), _capacity(N)
+	{}
+	explicit dvector(size_t max_sz) : _m_data(inline_data()), _sz(0), _capacity(N)
 	{
-		_sz = 0;
-		_capacity = max_sz;
-		if (_capacity > 0) {
-			_m_data = static_cast<T*>(malloc(_capacity * sizeof(T)));
-			assert(_m_data);
-		}
+		reserve(max_sz);
 	}
 
 	// copy constructor
-	dvector(const dvector& other)
+	dvector(const dvector& other) : _m_data(inline_data()), _sz(0), _capacity(N)
 	{
+		reserve(other._sz);
+		for (Index i = 0; i < other._sz; i++)
+			new (_m_data + i) T(other._m_data[i]);
 		_sz = other._sz;
-		_capacity = other._capacity;
-		_m_data = static_cast<T*>(malloc(_capacity * sizeof(T)));
-		assert(_m_data);
-		for (Index i = 0; i < _sz; i++)
-			_m_data[i] = other._m_data[i];
+	}
+	// move constructor
+	dvector(dvector&& other) : _m_data(inline_data()), _sz(0), _capacity(N)
+	{
+		take(other);
 	}
 
 	// assignment operator
 	dvector& operator=(const dvector& other)
 	{
-		if (this != other) {
-			if (_capacity < other._capacity) {
-				_m_data = static_cast<T*>(realloc(_m_data, other._capacity));
-				assert(_m_data);
-				_capacity = other._capacity;
-			}
+		if (this != &other) {
+			destroy();
+			reserve(other._sz);
 			for (Index i = 0; i < other._sz; i++)
-				_m_data[i] = other._m_data[i];
+				new (_m_data + i) T(other._m_data[i]);
 			_sz = other._sz;
 		}
 		return *this;
 	}
+	dvector& operator=(dvector&& other)
+	{
+		if (this != &other) {
+			release();
+			take(other);
+		}
+		return *this;
+	}
 
 	// destructor
 	~dvector()
 	{
-		if (_m_data)
-			free(_m_data);
+		release();
 	}
 
-	short dimension()
+	short dimension() const
 	{
 		return 1;
 	}
 
 	// unsafe
-	T& operator[](const Index& index) const
-	{
-		return _m_data[index];
-	}
+	T&       operator[](const Index& index)       { return _m_data[index]; }
+	const T& operator[](const Index& index) const { return _m_data[index]; }
+
+	iterator       begin()       { return _m_data; }
+	iterator       end()         { return _m_data + _sz; }
+	const_iterator begin() const { return _m_data; }
+	const_iterator end()   const { return _m_data + _sz; }
+	const T*       data()  const { return _m_data; }
 
 	void clear()
 	{
-		_sz = 0;
+		destroy();
 	}
 
-	size_t size()
+	size_t size() const
 	{
 		return _sz;
 	}
 
-	bool empty()
+	size_t capacity() const
+	{
+		return _capacity;
+	}
+
+	// true if the elements are in a heap block and not inside the object.
+	bool on_heap() const
+	{
+		return !is_inline();
+	}
+
+	bool empty() const
 	{
 		return _sz == 0;
 	}
 
+	void reserve(size_t capacity)
+	{
+		if (capacity > _capacity)
+			reallocate(capacity);
+	}
+
+	// capacity down to the size, back inside the object if it fits.
+	void shrink_to_fit()
+	{
+		if (_sz < _capacity)
+			reallocate(_sz);
+	}
+
 	void push_back(const T& data)
 	{
-		if (_sz == _capacity)
+		if (_sz == _capacity) {
+			T value(data); // data may be an element of this vector.
 			stretch_capacity();
-		_m_data[_sz++] = data;
+			new (_m_data + _sz++) T(std::move(value));
+			return;
+		}
+		new (_m_data + _sz++) T(data);
+	}
+	void push_back(T&& data)
+	{
+		if (_sz == _capacity) {
+			T value(std::move(data));
+			stretch_capacity();
+			new (_m_data + _sz++) T(std::move(value));
+			return;
+		}
+		new (_m_data + _sz++) T(std::move(data));
 	}
 
 	void pop_back()
 	{
-		_sz = (_sz > 0) ? --_sz : _sz;
+		if (_sz > 0)
+			_m_data[--_sz].~T();
 	}
 
 	T& back()
 	{
-		if (_sz > 0)
-			return _m_data[_sz - 1];
-		assert(false);
-		return NULL_DATA; // return reference on stack? unsafe TODOs: use smart_ptrs
+		assert(_sz > 0);
+		return _m_data[_sz - 1];
 	}
 
-
+	// data before the element at index; index == size() appends.
 	void insert(size_t index, const T& data)
 	{
-		move_right(index, 1);
-		_m_data[index] = data;
+		if (index > _sz) return; // bad index
+		T value(data);
+		if (index == _sz) {
+			push_back(std::move(value));
+			return;
+		}
+		if (_sz == _capacity)
+			stretch_capacity();
+		new (_m_data + _sz) T(std::move(_m_data[_sz - 1]));
+		for (Index i = _sz - 1; i > index; i--)
+			_m_data[i] = std::move(_m_data[i - 1]);
+		_m_data[index] = std::move(value);
+		_sz++;
 	}
 
 	// erase 'n' element starting from 'index'
 	void erase(size_t index, size_t n)
 	{
-		move_left(index, n);
+		if (index >= _sz) return; // bad index
+		if (n > _sz - index)
+			n = _sz - index;
+		for (size_t i = index; i + n < _sz; i++)
+			_m_data[i] = std::move(_m_data[i + n]);
+		for (size_t i = _sz - n; i < _sz; i++)
+			_m_data[i].~T();
+		_sz = static_cast<uint32_t>(_sz - n);
 	}
 
 	// linear search
-	int find(const T& data)
+	int find(const T& data) const
 	{
 		for (Index i = 0; i < _sz; i++)
 			if (_m_data[i] == data)
@@ -167,8 +276,8 @@ public:
 		return -1;
 	}
 
-	bool exists(const T& data)
+	bool exists(const T& data) const
 	{
-		return (find(data) > 0);
+		return (find(data) >= 0);
 	}
 };
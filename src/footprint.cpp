@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// System side of footprint.h: resident memory of the process and handing
+// freed heap back. Heap tracking is in heapTracking.cpp.
+
+#include <stdlib.h>
+#include <fstream>
+#include "footprint.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+bool footprint::release_free_memory()
+{
+#if defined(__GLIBC__)
+	return malloc_trim(0) != 0;
+#else
+	return false;
+#endif
+}
+
+size_t footprint::resident_bytes()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+	return pmc.WorkingSetSize;
+#elif defined(__linux__)
+	ifstream statm("/proc/self/statm");
+	size_t pages = 0, resident = 0;
+	if (!(statm >> pages >> resident))
+		return 0;
+	return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+	return 0;
+#endif
+}
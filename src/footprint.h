@@ -0,0 +1,180 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Memory Footprint:
+//      Bytes taken by the graph and by algorithm results, structure by
+// structure. Sizes are computed from the containers, the way the heap
+// lays them out: every allocation is rounded up to 16 bytes plus an
+// allocator header, a set element is a tree node of 4 words plus the
+// value, and a string longer than its inline buffer has a block of its
+// own. The result is an estimate, close to what the allocator hands out.
+//
+// Heap tracking: heapTracking.cpp replaces the global operator new and
+// delete to count live heap bytes, with the peak since the last reset,
+// both for the process and for the calling thread (what its allocations
+// minus its frees reached). Blocks are counted at the size the allocator
+// reports, so tracking adds no memory. Programs that do not link that
+// file, or build with -DBGA_NO_STATS, have tracking() false.
+//
+// Example:
+//       footprint::report usage;
+//       graph->memory(usage);
+//       usage.print(cout);
+
+#ifndef GRAPH_FOOTPRINT_H
+#define GRAPH_FOOTPRINT_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+
+namespace footprint {
+
+	// bytes the heap takes for an allocation of n bytes.
+	inline size_t heap_block(size_t n)
+	{
+		if (n == 0)
+			return 0;
+		return max<size_t>(32, (n + sizeof(size_t) + 15) & ~size_t(15));
+	}
+	// heap bytes of a string; short strings live inside the object.
+	inline size_t string_bytes(const string& s)
+	{
+		const char* data = s.data();
+		const char* self = reinterpret_cast<const char*>(&s);
+		if (data >= self && data < self + sizeof(s))
+			return 0;
+		return heap_block(s.capacity() + 1);
+	}
+	template <class T>
+	size_t vector_bytes(const vector<T>& v)
+	{
+		return heap_block(v.capacity() * sizeof(T));
+	}
+	// one element of a std::set or std::map: color, parent, left, right, value.
+	template <class T>
+	size_t tree_node_bytes()
+	{
+		return heap_block(4 * sizeof(void*) + sizeof(T));
+	}
+
+	// structures with their element count and bytes.
+	class report {
+	private:
+		struct item {
+			string name_;
+			size_t count_;
+			size_t bytes_;
+		};
+		vector<item> items_;
+	public:
+		void add(const string& name, size_t count, size_t bytes)
+		{
+			item i = { name, count, bytes };
+			items_.push_back(i);
+		}
+		void clear() { items_.clear(); }
+		bool empty() const { return items_.empty(); }
+		size_t total() const
+		{
+			size_t bytes = 0;
+			for (size_t i = 0; i < items_.size(); i++)
+				bytes += items_[i].bytes_;
+			return bytes;
+		}
+		void print(ostream& out) const
+		{
+			out << "structure count bytes\n";
+			out << "========= ===== =====\n";
+			for (size_t i = 0; i < items_.size(); i++)
+				out << items_[i].name_ << " " << items_[i].count_ << " " << items_[i].bytes_ << "\n";
+			out << "total - " << total() << "\n";
+		}
+	};
+
+	// set by heapTracking.cpp when it counts allocations.
+	inline atomic<bool>& tracked()
+	{
+		static atomic<bool> t(false);
+		return t;
+	}
+	inline bool tracking() { return tracked().load(memory_order_relaxed); }
+
+	struct counters {
+		atomic<int64_t> live_;
+		atomic<int64_t> peak_;
+		atomic<int64_t> base_;  // live bytes at the last reset_peak().
+	};
+	inline counters& process()
+	{
+		static counters c = { {0}, {0}, {0} };
+		return c;
+	}
+	// net bytes allocated by the calling thread, its peak and the base at reset.
+	inline int64_t* thread_counters()
+	{
+		static thread_local int64_t c[3] = { 0, 0, 0 };
+		return c;
+	}
+
+	inline void note_alloc(size_t n)
+	{
+		counters& c = process();
+		int64_t live = c.live_.fetch_add(static_cast<int64_t>(n), memory_order_relaxed) + static_cast<int64_t>(n);
+		int64_t peak = c.peak_.load(memory_order_relaxed);
+		while (live > peak && !c.peak_.compare_exchange_weak(peak, live, memory_order_relaxed))
+			;
+		int64_t* t = thread_counters();
+		t[0] += static_cast<int64_t>(n);
+		t[1] = max(t[1], t[0]);
+	}
+	inline void note_free(size_t n)
+	{
+		process().live_.fetch_sub(static_cast<int64_t>(n), memory_order_relaxed);
+		thread_counters()[0] -= static_cast<int64_t>(n);
+	}
+
+	// heap bytes in use by the process.
+	inline int64_t live() { return process().live_.load(memory_order_relaxed); }
+	// starts a new peak of the process.
+	inline void reset_peak()
+	{
+		counters& c = process();
+		int64_t now = c.live_.load(memory_order_relaxed);
+		c.peak_.store(now, memory_order_relaxed);
+		c.base_.store(now, memory_order_relaxed);
+	}
+	// starts a new peak of the calling thread.
+	inline void reset_thread_peak()
+	{
+		int64_t* t = thread_counters();
+		t[1] = t[2] = t[0];
+	}
+	// highest heap use since reset_peak(), above the heap in use then.
+	inline int64_t peak_growth()
+	{
+		counters& c = process();
+		return c.peak_.load(memory_order_relaxed) - c.base_.load(memory_order_relaxed);
+	}
+	// same for allocations of the calling thread only.
+	inline int64_t thread_peak_growth()
+	{
+		int64_t* t = thread_counters();
+		return t[1] - t[2];
+	}
+
+	// hands freed heap back to the system, where the allocator allows it.
+	bool release_free_memory();
+	// resident set size of the process, 0 if unknown.
+	size_t resident_bytes();
+}
+
+#endif
@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Synthetic Graph Generators:
+//      Write graphs in the input format of readBasicGraph, with nodes
+// n0, n1, ..., integer weights in [1, 100] and no self loops. The same
+// kind, scale, degree and seed always give the same file, on any
+// platform: random numbers come from splitmix64, not from the standard
+// distributions whose output differs between libraries.
+//
+//   rmat   directed, 2^scale nodes, degree * 2^scale edges. Each edge picks
+//          a quadrant of the adjacency matrix scale times with
+//          probabilities a=0.57, b=0.19, c=0.19, d=0.05 (Graph500
+//          Kronecker); node ids are shuffled. Skewed degrees.
+//   er     undirected Erdos-Renyi G(n, m), 2^scale nodes and
+//          degree * 2^scale / 2 edges between uniform random node pairs.
+//   grid   undirected 2D grid, 2^scale nodes, road network like: small
+//          degree and large diameter.
+//   chain  directed acyclic, 2^scale nodes in one chain n0 -> n1 -> ...
+//          plus degree-1 short forward edges per node. Depth is 2^scale.
+//   star   directed, 2^scale nodes, hub n0 with an edge to every other
+//          node, in random order, plus degree-1 uniform random edges out of
+//          each of them. One node of very high degree.
+//
+// Reference: Chakrabarti, Zhan, Faloutsos, "R-MAT: A Recursive Model for
+//            Graph Mining", 2004.
+//            https://graph500.org/?page_id=12
+
+#ifndef GRAPH_GENERATORS_H
+#define GRAPH_GENERATORS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace generators {
+
+	class splitmix {
+	private:
+		uint64_t state_;
+	public:
+		splitmix(uint64_t seed) : state_(seed) {}
+		uint64_t next()
+		{
+			uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		}
+		// uniform in [0, n).
+		uint64_t below(uint64_t n) { return next() % n; }
+		// uniform in [0, 1).
+		double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+	};
+
+	inline void write_edge(ostream& out, uint64_t from, uint64_t to, splitmix& rng)
+	{
+		out << 'n' << from << " n" << to << ' ' << 1 + rng.below(100) << '\n';
+	}
+
+	inline void rmat(ostream& out, size_t scale, size_t degree, uint64_t seed)
+	{
+		splitmix rng(seed);
+		uint64_t n = uint64_t(1) << scale;
+		vector<uint64_t> perm(n);
+		for (uint64_t i = 0; i < n; i++)
+			perm[i] = i;
+		for (uint64_t i = n; i > 1; i--)
+			swap(perm[i - 1], perm[rng.below(i)]);
+
+		out << "graph directed\n";
+		for (uint64_t e = 0; e < n * degree; e++)
+		{
+			uint64_t from = 0, to = 0;
+			for (size_t level = 0; level < scale; level++)
+			{
+				double r = rng.unit();
+				from <<= 1;
+				to   <<= 1;
+				if (r < 0.57)
+					;
+				else if (r < 0.76)
+					to |= 1;
+				else if (r < 0.95)
+					from |= 1;
+				else {
+					from |= 1;
+					to   |= 1;
+				}
+			}
+			if (from != to)
+				write_edge(out, perm[from], perm[to], rng);
+		}
+	}
+
+	inline void erdos_renyi(ostream& out, size_t scale, size_t degree, uint64_t seed)
+	{
+		splitmix rng(seed);
+		uint64_t n = uint64_t(1) << scale;
+		out << "graph undirected\n";
+		for (uint64_t e = 0; e < n * degree / 2; e++)
+		{
+			uint64_t from = rng.below(n), to = rng.below(n);
+			if (from != to)
+				write_edge(out, from, to, rng);
+		}
+	}
+
+	inline void grid(ostream& out, size_t scale, uint64_t seed)
+	{
+		splitmix rng(seed);
+		uint64_t rows = uint64_t(1) << (scale / 2), cols = uint64_t(1) << (scale - scale / 2);
+		out << "graph undirected\n";
+		for (uint64_t r = 0; r < rows; r++)
+			for (uint64_t c = 0; c < cols; c++)
+			{
+				uint64_t u = r * cols + c;
+				if (c + 1 < cols)
+					write_edge(out, u, u + 1, rng);
+				if (r + 1 < rows)
+					write_edge(out, u, u + cols, rng);
+			}
+	}
+
+	inline void chain(ostream& out, size_t scale, size_t degree, uint64_t seed)
+	{
+		const uint64_t window = 16;
+		splitmix rng(seed);
+		uint64_t n = uint64_t(1) << scale;
+		out << "graph directed\n";
+		for (uint64_t u = 0; u + 1 < n; u++)
+		{
+			write_edge(out, u, u + 1, rng);
+			for (size_t k = 1; k < degree; k++)
+			{
+				uint64_t v = u + 2 + rng.below(window);
+				if (v < n)
+					write_edge(out, u, v, rng);
+			}
+		}
+	}
+
+	inline void star(ostream& out, size_t scale, size_t degree, uint64_t seed)
+	{
+		splitmix rng(seed);
+		uint64_t n = uint64_t(1) << scale;
+		vector<uint64_t> leaves;
+		for (uint64_t u = 1; u < n; u++)
+			leaves.push_back(u);
+		for (uint64_t i = leaves.size(); i > 1; i--)
+			swap(leaves[i - 1], leaves[rng.below(i)]);
+
+		out << "graph directed\n";
+		for (size_t i = 0; i < leaves.size(); i++)
+			write_edge(out, 0, leaves[i], rng);
+		for (uint64_t u = 1; u < n; u++)
+			for (size_t k = 1; k < degree; k++)
+			{
+				uint64_t v = rng.below(n);
+				if (v != u)
+					write_edge(out, u, v, rng);
+			}
+	}
+
+	// kind is rmat, er, grid, chain or star; returns false on error.
+	inline bool write(string filename, string kind, size_t scale, size_t degree, uint64_t seed)
+	{
+		if (kind != "rmat" && kind != "er" && kind != "grid" && kind != "chain" && kind != "star") {
+			cerr << "Error: unknown graph kind " << kind << ". Options are rmat, er, grid, chain and star.\n";
+			return false;
+		}
+		ofstream out(filename.c_str());
+		if (!out) {
+			cerr << "Error: could not open file " << filename << ".\n";
+			return false;
+		}
+		if (kind == "rmat")
+			rmat(out, scale, degree, seed);
+		else if (kind == "er")
+			erdos_renyi(out, scale, degree, seed);
+		else if (kind == "grid")
+			grid(out, scale, seed);
+		else if (kind == "chain")
+			chain(out, scale, degree, seed);
+		else
+			star(out, scale, degree, seed);
+		return static_cast<bool>(out);
+	}
+}
+
+#endif
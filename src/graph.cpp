@@ -6,7 +6,9 @@
 //
 
 #include <fstream>
+#include <string.h>
 #include "graph.h"
+#include "parallel.h"
 
 using namespace std;
 
@@ -69,70 +71,248 @@ void basicGraph::bGraph::addNodesAndEdge(string n1, string n2, size_t weight)
 	return;
 }
 
+// A sorted insert moves the tail of the edge list, so loading a node of
+// degree d that way costs O(d^2); appending and sorting once is O(d log d).
+void basicGraph::bGraph::appendNodesAndEdge(string n1, string n2, size_t weight)
+{
+	basicGraph::bNode* node1 = addNode(n1);
+	basicGraph::bNode* node2 = addNode(n2);
+
+	const basicGraph::bEdge* edge = addEdge(node1, node2, weight);
+	node1->appendEdge(edge);
+	if (!directed() && node2 != node1)
+		node2->appendEdge(edge);
+}
+
+void basicGraph::bGraph::sortEdgeLists()
+{
+	parallel::parallel_for(0, nodeIds_.size(), [this](size_t id) {
+		const_cast<bNode*>(nodeIds_[id])->sortEdges();
+	}, 64);
+}
+
+bool
+basicGraph::bGraph::weighted() const
+{
+	set<const bEdge*, edgeCompare>::iterator eiter = edgeset_.begin();
+	for (; eiter != edgeset_.end(); eiter++)
+		if (!(*eiter)->hasWeight())
+			return false;
+	return true;
+}
+
 void
 basicGraph::bGraph::print() const
 {
-	cout << "graph " << (isDirected_ ? "directed" : "undirected") << endl;
+	output::writer out(cout);
+	print(out);
+}
+
+void
+basicGraph::bGraph::print(output::writer& out) const
+{
+	if (out.text())
+		out << "graph " << (isDirected_ ? "directed" : "undirected") << "\n";
+	else
+		out.header("from,to,weight");
 	set<const bEdge*, edgeCompare>::iterator eiter = edgeset_.begin();
 	for (; eiter != edgeset_.end(); eiter++)
-		(*eiter)->print();
+		(*eiter)->print(out);
 }
 
-basicGraph::bGraph *basicGraph::bGraph::readBasicGraph(string filename)
+// a line of the graph file, tokenized. Tokens are split at single spaces
+// like tokenizeLine does: "a  b" has an empty token in the middle, and a
+// trailing space adds no token.
+struct parsedLine {
+	enum { SKIP, INVALID, GRAPH, EDGE, BAD_WEIGHT } kind_;
+	size_t line_, lineLen_;   // whole line, for messages.
+	size_t from_, fromLen_;   // first token.
+	size_t to_, toLen_;       // second token.
+	size_t weight_, weightLen_; // weight, or position of a weight stol rejects.
+};
+
+static void parse_line(const string& text, size_t pos, size_t end, parsedLine& p)
 {
-	const unsigned int BUFFER_SIZE = 1024;
-	char line[BUFFER_SIZE];
+	size_t tokens[3], lens[3], nTokens = 0;
+	p.line_    = pos;
+	p.lineLen_ = end - pos;
+	for (size_t t = pos; pos < end && nTokens < 3; pos = t + 1)
+	{
+		const void* blank = memchr(&text[pos], ' ', end - pos);
+		t = blank ? static_cast<const char*>(blank) - text.data() : end;
+		tokens[nTokens] = pos;
+		lens[nTokens++] = t - pos;
+		if (t == end)
+			break;
+	}
+	if (nTokens == 0 || text[tokens[0]] == '#') {
+		p.kind_ = parsedLine::SKIP;
+		return;
+	}
+	if (nTokens < 2) {
+		p.kind_ = parsedLine::INVALID;
+		return;
+	}
+	p.from_ = tokens[0];
+	p.fromLen_ = lens[0];
+	p.to_ = tokens[1];
+	p.toLen_ = lens[1];
+	p.weight_ = basicGraph::bEdge::INVALID_WEIGHT;
+	p.kind_ = text.compare(p.from_, p.fromLen_, "graph") == 0 ? parsedLine::GRAPH : parsedLine::EDGE;
+	if (p.kind_ == parsedLine::EDGE && nTokens > 2)
+	{
+		try {
+			p.weight_ = stol(text.substr(tokens[2], lens[2]));
+		}
+		catch (...) {
+			p.kind_      = parsedLine::BAD_WEIGHT;
+			p.weight_    = tokens[2];
+			p.weightLen_ = lens[2];
+		}
+	}
+}
 
-	filebuf buf;
-	buf.open(filename.c_str(), ios::in);
-	if (!buf.is_open()) {
+// Lines are tokenized in parallel, one chunk of the file per thread, and
+// added to the graph in file order.
+basicGraph::bGraph *basicGraph::bGraph::readBasicGraph(string filename)
+{
+	ifstream file(filename.c_str(), ios::in | ios::binary);
+	if (!file.is_open()) {
 		cerr << "could not open file" << filename << endl;
 		return nullptr;
 	}
-	bGraph* new_graph = new bGraph();
-
-	istream graph_stream(&buf);
-	while (!graph_stream.eof() ) { 
-		graph_stream.getline(line, BUFFER_SIZE);
-
-		vector<string> tokens;
-		tokenizeLine(line, tokens);
+	string text;
+	file.seekg(0, ios::end);
+	text.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0, ios::beg);
+	if (!text.empty())
+		file.read(&text[0], text.size());
+	file.close();
 
-		if (tokens.size() == 0 || tokens[0][0] == '#') {
-			continue;
+	vector<vector<parsedLine>> parsed(parallel::nThreads());
+	parallel::for_chunks(0, text.size(), [&](size_t lo, size_t hi, size_t chunk) {
+		// a line belongs to the chunk it starts in.
+		if (lo > 0 && text[lo - 1] != '\n') {
+			size_t eol = text.find('\n', lo);
+			lo = eol == string::npos ? text.size() : eol + 1;
 		}
-		if (tokens.size() < 2)
+		for (size_t pos = lo; pos < hi; )
 		{
-			cerr << "invlid input line in graph " << line << endl;
-			continue;
+			size_t eol = text.find('\n', pos);
+			size_t end = eol == string::npos ? text.size() : eol;
+			size_t next = end + 1;
+			if (end > pos && text[end - 1] == '\r') // read in binary, so as text mode would.
+				end--;
+			parsedLine p;
+			parse_line(text, pos, end, p);
+			if (p.kind_ != parsedLine::SKIP)
+				parsed[chunk].push_back(p);
+			pos = next;
 		}
+	}, size_t(1) << 16);
 
-
-		if (tokens[0] == "graph") {
-			if (tokens[1] == "undirected")
-				new_graph->setDirected(false);
-			else if (tokens[1] == "directed")
-				new_graph->setDirected(true);
-			else
-				cerr << "Error: invalid keyword after \'graph\' : " << tokens[1];
-		}
-		else {
-			size_t weight = basicGraph::bEdge::INVALID_WEIGHT;
-			if (tokens.size() > 2)
+	bGraph* new_graph = new bGraph();
+	for (size_t c = 0; c < parsed.size(); c++)
+	{
+		for (size_t i = 0; i < parsed[c].size(); i++)
+		{
+			const parsedLine& p = parsed[c][i];
+			if (p.kind_ == parsedLine::INVALID)
 			{
-				weight = stol(tokens[2]);
-				if (weight < 0)
-					cerr << "Warning: negative weight for the edge " << line << ".\n";
+				cerr << "invlid input line in graph " << text.substr(p.line_, p.lineLen_) << endl;
+				continue;
 			}
-
-			new_graph->addNodesAndEdge(tokens[0], tokens[1], weight);
+			if (p.kind_ == parsedLine::BAD_WEIGHT)
+				stol(text.substr(p.weight_, p.weightLen_)); // throws here, in file order.
+			string token = text.substr(p.to_, p.toLen_);
+			if (p.kind_ == parsedLine::GRAPH) {
+				if (token == "undirected")
+					new_graph->setDirected(false);
+				else if (token == "directed")
+					new_graph->setDirected(true);
+				else
+					cerr << "Error: invalid keyword after \'graph\' : " << token;
+			}
+			else
+				new_graph->appendNodesAndEdge(text.substr(p.from_, p.fromLen_), token, p.weight_);
 		}
+		vector<parsedLine>().swap(parsed[c]);
 	}
-	buf.close();
+	new_graph->sortEdgeLists();
 
 	return new_graph;
 }
 
+void
+basicGraph::bGraph::memory(footprint::report& usage) const
+{
+	size_t nameBytes = 0, adjacency = 0, adjacencyBytes = 0, weighted = 0;
+	set<const bNode*, nodeCompare>::iterator niter;
+	for (niter = nodeBegin(); niter != nodeEnd(); niter++)
+	{
+		nameBytes += footprint::string_bytes((*niter)->name());
+		adjacency += (*niter)->degree();
+		adjacencyBytes += (*niter)->edgeListBytes();
+	}
+	set<const bEdge*, edgeCompare>::iterator eiter;
+	for (eiter = edgeBegin(); eiter != edgeEnd(); eiter++)
+		weighted += (*eiter)->hasWeight();
+
+	usage.add("nodes",     nNodes(),  nNodes() * footprint::heap_block(sizeof(bNode)));
+	usage.add("names",     nNodes(),  nameBytes);
+	usage.add("edges",     nEdges(),  weighted * footprint::heap_block(sizeof(bWeightedEdge)) +
+	                                  (nEdges() - weighted) * footprint::heap_block(sizeof(bEdge)));
+	usage.add("node_set",  nNodes(),  nNodes() * footprint::tree_node_bytes<const bNode*>());
+	usage.add("edge_set",  nEdges(),  nEdges() * footprint::tree_node_bytes<const bEdge*>());
+	usage.add("adjacency", adjacency, adjacencyBytes); // beyond the edges inside the nodes.
+	usage.add("id_index",  nodeIds_.size(), footprint::vector_bytes(nodeIds_));
+	usage.add("edge_index", edgeIds_.size(), footprint::vector_bytes(edgeIds_));
+}
+
+void
+basicGraph::bGraph::compact()
+{
+	vector<const bNode*> oldNodes;
+	oldNodes.swap(nodeIds_);
+	vector<const bEdge*> oldEdges(edgeset_.begin(), edgeset_.end());
+	nodeset_.clear();
+	edgeset_.clear();
+	vector<const bEdge*>(oldEdges.size()).swap(edgeIds_);
+
+	vector<bNode*> nodes(oldNodes.size());
+	nodeIds_.reserve(oldNodes.size());
+	for (size_t id = 0; id < oldNodes.size(); id++)
+	{
+		nodes[id] = new bNode(oldNodes[id]->name(), id);
+		nodeset_.insert(nodes[id]);
+		nodeIds_.push_back(nodes[id]);
+	}
+	// edges come in set order, so each insert lands at the end.
+	for (size_t i = 0; i < oldEdges.size(); i++)
+	{
+		const bEdge* old = oldEdges[i];
+		bNode* n1 = nodes[old->n1()->id()];
+		bNode* n2 = nodes[old->n2()->id()];
+		const bEdge* e = old->hasWeight() ?
+			new bWeightedEdge(n1, n2, dynamic_cast<const bWeightedEdge*>(old)->weight(), old->id()) :
+			new bEdge(n1, n2, old->id());
+		edgeset_.insert(edgeset_.end(), e);
+		edgeIds_[e->id()] = e;
+		n1->addEdge(e);
+		if (!directed())
+			n2->addEdge(e);
+	}
+
+	for (size_t id = 0; id < nodes.size(); id++)
+		nodes[id]->shrinkEdgeList();
+
+	for (size_t i = 0; i < oldNodes.size(); i++)
+		delete oldNodes[i];
+	for (size_t i = 0; i < oldEdges.size(); i++)
+		delete oldEdges[i];
+	footprint::release_free_memory();
+}
+
 basicGraph::bGraph::~bGraph() {
 	set<const bNode*, nodeCompare>::iterator niter = nodeset_.begin();
 	for (; niter != nodeset_.end(); niter++)
@@ -14,7 +14,11 @@
 #include <sstream>
 #include <set>
 #include <vector>
+#include <algorithm>
 #include <limits.h>
+#include "dvector.h"
+#include "resultWriter.h"
+#include "footprint.h"
 
 using namespace std;
 
@@ -36,31 +40,59 @@ namespace basicGraph {
 	void tokenizeLine(char*  line, std::vector<std::string> &tokens);
 
 	class bNode {
+	public:
+		enum { INLINE_EDGES = 8 };                 // edges kept inside the node, more go to the heap.
+		typedef const bEdge* const* edgeIterator;  // edges in edgeCompare order.
 	private:
-		string                         name_;
-		set<const bEdge*, edgeCompare> edgelist_;
+		string                               name_;
+		size_t                               id_;       // dense index in [0, nNodes())
+		dvector<const bEdge*, INLINE_EDGES>  edgelist_; // sorted by edgeCompare, no two equal.
 	public:
-		bNode(string name) : name_(name) {}
-		string name() const { return name_; }
+		bNode(string name, size_t id = 0) : name_(name), id_(id) {}
+		const string& name() const { return name_; }
+		size_t id()   const { return id_; }
 		bool addEdge(const bEdge* e) {
-			if (!e || edgelist_.find(e) != edgelist_.end())
+			if (!e)
+				return false;
+			const bEdge** pos = lower_bound(edgelist_.begin(), edgelist_.end(), e, edgeCompare());
+			if (pos != edgelist_.end() && !edgeCompare()(e, *pos))
 				return false;
-			edgelist_.insert(e);
+			edgelist_.insert(pos - edgelist_.begin(), e);
 			return true;
 		}
+		// adds e at the end, out of order, for bulk loads; sortEdges()
+		// restores the order once all edges are in.
+		void appendEdge(const bEdge* e) {
+			if (e)
+				edgelist_.push_back(e);
+		}
+		void sortEdges() {
+			if (!is_sorted(edgelist_.begin(), edgelist_.end(), edgeCompare()))
+				sort(edgelist_.begin(), edgelist_.end(), edgeCompare());
+			const bEdge** last = unique(edgelist_.begin(), edgelist_.end(),
+				[](const bEdge* a, const bEdge* b) { return !edgeCompare()(a, b); });
+			edgelist_.erase(last - edgelist_.begin(), edgelist_.end() - last);
+		}
 		void clearEdgeList() { edgelist_.clear(); }
-		set<const bEdge*, edgeCompare>::iterator edgeBegin() const { return edgelist_.begin(); }
-		set<const bEdge*, edgeCompare>::iterator edgeEnd()   const { return edgelist_.end(); }
+		void shrinkEdgeList() { edgelist_.shrink_to_fit(); }
+		size_t degree() const { return edgelist_.size(); }
+		// heap bytes of the edge list, 0 while it fits inside the node.
+		size_t edgeListBytes() const {
+			return edgelist_.on_heap() ? footprint::heap_block(edgelist_.capacity() * sizeof(const bEdge*)) : 0;
+		}
+		edgeIterator edgeBegin() const { return edgelist_.begin(); }
+		edgeIterator edgeEnd()   const { return edgelist_.end(); }
 	};
 
 	class bEdge {
 	private:
 		const bNode* n1_;    // from node for directd graphs
 		const bNode* n2_;    // to   node for directed graphs
+		size_t       id_;    // dense index in [0, nEdges())
 	public:
 		static const long INVALID_WEIGHT;
-		bEdge(const bNode* n1 = 0x0, const bNode* n2 = 0x0)
-			: n1_(n1), n2_(n2)
+		bEdge(const bNode* n1 = 0x0, const bNode* n2 = 0x0, size_t id = 0)
+			: n1_(n1), n2_(n2), id_(id)
 		{}
 		string name() const
 		{
@@ -75,6 +107,7 @@ namespace basicGraph {
 		}
 		const bNode* n1()             const { return n1_;  }
 		const bNode* n2()             const { return n2_;  }
+		size_t       id()             const { return id_;  }
 		virtual bool  hasWeight()     const {return false; }
 		void swap_nodes() // used to compute transpose of graph
 		{
@@ -91,9 +124,18 @@ namespace basicGraph {
 			else
 				return nullptr;
 		}
-		virtual void print()          const
+		// from and to names, and the weight if any.
+		virtual void print(output::writer& out) const
 		{
-			cout << name() << "\n";
+			if (out.text())
+				out << n1_->name() << ' ' << n2_->name() << '\n';
+			else
+				out.field(n1_->name()).field(n2_->name()).field("").end_record();
+		}
+		void print() const
+		{
+			output::writer out(cout);
+			print(out);
 		}
 		virtual ~bEdge() {}
 	};
@@ -101,18 +143,28 @@ namespace basicGraph {
 	private:
 		const size_t weight_; // weight of the edge.
 	public:
-		bWeightedEdge(const bNode* n1=0x0, const bNode* n2=0x0, const size_t w=INVALID_WEIGHT)
-			:  bEdge(n1, n2), weight_(w)
+		bWeightedEdge(const bNode* n1=0x0, const bNode* n2=0x0, const size_t w=INVALID_WEIGHT, size_t id=0)
+			:  bEdge(n1, n2, id), weight_(w)
 		{}
 		virtual bool  hasWeight()     const { return true; }
 		const size_t weight() const { return weight_; }
-		virtual void print()          const 
-		{ 
-			stringstream wt;
-			if (weight_ != INVALID_WEIGHT)
-				wt << " " << weight_;
-
-			cout << name() << wt.str() << "\n";
+		using bEdge::print;
+		virtual void print(output::writer& out) const
+		{
+			bool weighted = weight_ != static_cast<size_t>(INVALID_WEIGHT);
+			if (out.text()) {
+				out << n1()->name() << ' ' << n2()->name();
+				if (weighted)
+					out << ' ' << weight_;
+				out << '\n';
+				return;
+			}
+			out.field(n1()->name()).field(n2()->name());
+			if (weighted)
+				out.field(weight_);
+			else
+				out.field("");
+			out.end_record();
 		}
 		virtual ~bWeightedEdge() {}
 	};
@@ -122,6 +174,11 @@ namespace basicGraph {
 		bool                           isDirected_;
 		set<const bNode*, nodeCompare> nodeset_;
 		set<const bEdge*, edgeCompare> edgeset_;
+		vector<const bNode*>           nodeIds_;  // node indexed by its dense id
+		vector<const bEdge*>           edgeIds_;  // edge indexed by its dense id
+
+		// addNodesAndEdge without ordering the edge lists, see sortEdgeLists.
+		void appendNodesAndEdge(string, string, size_t);
 	public:
 		bGraph(bool directed=false) : isDirected_(directed) {}
 		bGraph(const bGraph& other);
@@ -138,8 +195,9 @@ namespace basicGraph {
 		bNode* addNode(string name) {
 			const bNode* n = findNode(name);
 			if (!n) {
-				n = new bNode(name);
+				n = new bNode(name, nodeIds_.size());
 				nodeset_.insert(n);
+				nodeIds_.push_back(n);
 			}
 			return const_cast<bNode*>(n);
 		}
@@ -162,15 +220,27 @@ namespace basicGraph {
 			const bEdge* e = findEdge(n1, n2);
 			if (!e) {
 				e = weight == bEdge::INVALID_WEIGHT ? 
-					new bEdge(n1, n2) : 
-					new bWeightedEdge(n1, n2, weight);
-				edgeset_.insert(e);
+					new bEdge(n1, n2, edgeIds_.size()) : 
+					new bWeightedEdge(n1, n2, weight, edgeIds_.size());
+				pair<set<const bEdge*, edgeCompare>::iterator, bool> added = edgeset_.insert(e);
+				if (!added.second) { // same edge, that findEdge missed for its weight.
+					delete e;
+					e = *added.first;
+				}
+				else
+					edgeIds_.push_back(e);
 			}
 			return e;
 		}
 		void addNodesAndEdge(string, string, size_t);
+		// puts every edge list back in order after bNode::appendEdge.
+		void sortEdgeLists();
 		size_t nNodes() const { return nodeset_.size(); }
 		size_t nEdges() const { return edgeset_.size(); }
+		// true if every edge has a weight.
+		bool weighted() const;
+		const bNode* node(size_t id) const { return id < nodeIds_.size() ? nodeIds_[id] : nullptr; }
+		const bEdge* edge(size_t id) const { return id < edgeIds_.size() ? edgeIds_[id] : nullptr; }
 
 		// graph access methods
 		set<const bNode*, nodeCompare>::iterator nodeBegin() const { return nodeset_.begin(); }
@@ -179,6 +249,13 @@ namespace basicGraph {
 		set<const bEdge*, edgeCompare>::iterator edgeEnd()   const { return edgeset_.end();   }
 
 		void print() const;
+		void print(output::writer& out) const;
+		// bytes of nodes, names, edges, sets and adjacency, see footprint.h.
+		void memory(footprint::report& usage) const;
+		// rebuilds nodes (in id order), edges and sets in fresh, exact sized
+		// storage and returns freed heap to the system; node and edge ids
+		// are kept.
+		void compact();
 		static bGraph* readBasicGraph(string filename);
 		~bGraph();
 
@@ -27,6 +27,7 @@
 #include <functional>
 #include <algorithm>
 #include <assert.h>
+#include "stats.h"
 
 //using namespace std;
 
@@ -110,6 +111,7 @@ Heap<T, COMPARE>::heapify_down(size_t prnt)
 template<typename T, class COMPARE>
 void
 Heap<T, COMPARE>::push(const T& element) {
+	STATS_INC(HEAP_PUSHES);
 	size_t n = this->size();
 	((std::vector<T>*)this)->push_back(element);
 	heapify_up(n);
@@ -120,6 +122,7 @@ bool
 Heap<T, COMPARE>::pop(T& popped) {
 	if (!this->size()) return false;
 
+	STATS_INC(HEAP_POPS);
 	popped = (*this)[0];
 	(*this)[0] = (*this)[this->size() - 1];
 	((std::vector<T>*)this)->pop_back();
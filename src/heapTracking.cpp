@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Heap tracking for footprint.h: global operator new and delete count
+// every block in and out. The size of a block is asked from the
+// allocator (malloc_usable_size, malloc_size or _msize), plus the word
+// it keeps in front of the block, the same measure heap_block() uses;
+// nothing is added to the allocation. Where the allocator cannot tell,
+// no block is counted and tracking() stays false.
+//
+// Only the application links this file; the benchmark and the tests run
+// on the plain allocator.
+
+#include <stdlib.h>
+#include <new>
+#include "footprint.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define BGA_BLOCK_SIZE(p) malloc_usable_size(p)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define BGA_BLOCK_SIZE(p) malloc_size(p)
+#elif defined(_WIN32)
+#include <malloc.h>
+#define BGA_BLOCK_SIZE(p) _msize(p)
+#endif
+
+using namespace std;
+
+#if !defined(BGA_NO_STATS) && defined(BGA_BLOCK_SIZE)
+
+static size_t block_bytes(void* p)
+{
+	return BGA_BLOCK_SIZE(p) + sizeof(size_t);
+}
+
+static void* tracked_alloc(size_t n)
+{
+	void* p = malloc(n);
+	if (p)
+		footprint::note_alloc(block_bytes(p));
+	return p;
+}
+
+static void tracked_free(void* p)
+{
+	if (!p)
+		return;
+	footprint::note_free(block_bytes(p));
+	free(p);
+}
+
+static void* tracked_new(size_t n)
+{
+	void* p;
+	while ((p = tracked_alloc(n ? n : 1)) == nullptr)
+	{
+		new_handler handler = get_new_handler();
+		if (!handler)
+			throw bad_alloc();
+		handler();
+	}
+	return p;
+}
+
+static struct trackingOn {
+	trackingOn() { footprint::tracked().store(true); }
+} trackingOn_;
+
+void* operator new(size_t n)                                  { return tracked_new(n); }
+void* operator new[](size_t n)                                { return tracked_new(n); }
+void* operator new(size_t n, const nothrow_t&) noexcept       { return tracked_alloc(n ? n : 1); }
+void* operator new[](size_t n, const nothrow_t&) noexcept     { return tracked_alloc(n ? n : 1); }
+void  operator delete(void* p) noexcept                       { tracked_free(p); }
+void  operator delete[](void* p) noexcept                     { tracked_free(p); }
+void  operator delete(void* p, const nothrow_t&) noexcept     { tracked_free(p); }
+void  operator delete[](void* p, const nothrow_t&) noexcept   { tracked_free(p); }
+void  operator delete(void* p, size_t) noexcept               { tracked_free(p); }
+void  operator delete[](void* p, size_t) noexcept             { tracked_free(p); }
+
+#endif
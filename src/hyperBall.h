@@ -0,0 +1,200 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Approximate Neighborhood Function (HyperBall):
+//      Ball B(v, t) is the set of nodes that reach v in at most t steps.
+// The neighborhood function N(t) = sum of |B(v, t)| over all v counts the
+// pairs within distance t. Exact balls need a BFS per node; instead every
+// node keeps a HyperLogLog counter that estimates |B(v, t)|.
+//
+//   B(v, 0)   = { v }
+//   B(v, t+1) = B(v, t) ∪ B(u, t) for every in-edge (u, v)
+//
+//      Union of two HyperLogLog counters is a register wise max, so one
+// iteration is a pass over all edges. Iterations stop when no counter
+// changes; their number is a lower bound of the diameter.
+//
+//   effective diameter   t at which N(t) reaches 90% of its final value,
+//                        interpolated between iterations.
+//   harmonic centrality  of v is the sum of 1/d(u, v) over u != v,
+//                        from (|B(v, t)| - |B(v, t-1)|) / t.
+//
+//      A counter has 2^b registers of one byte each; relative error of an
+// estimate is about 1.04/sqrt(2^b). Counters are pulled from in-neighbors
+// in parallel into a second array; only neighbors whose counter changed in
+// the previous iteration are merged again.
+//
+// Reference: Boldi, Rosa, Vigna, "HyperANF: Approximating the Neighbourhood
+//            Function of Very Large Graphs on a Budget", WWW 2011.
+//            Boldi, Vigna, "In-Core Computation of Geometric Centralities
+//            with HyperBall", 2013.
+//            Flajolet, Fusy, Gandouet, Meunier, "HyperLogLog", 2007.
+
+#ifndef GRAPH_HYPERBALL_H
+#define GRAPH_HYPERBALL_H
+
+#include "graph.h"
+#include "csr.h"
+#include "parallel.h"
+#include "stats.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+namespace short_paths {
+
+	class hyperBall {
+	private:
+		const basicGraph::bGraph* graph_;
+		size_t                    log2m_;     // registers per counter = 2^log2m_.
+		size_t                    maxIterations_;
+		vector<double>            nf_;        // neighborhood function, N(t) at index t.
+		vector<double>            harmonic_;  // indexed by node id.
+
+		static uint64_t hash(uint64_t x)
+		{
+			x += 0x9E3779B97F4A7C15ULL;
+			x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+			return x ^ (x >> 31);
+		}
+
+		// counter of one node: register index from the top bits, rank of
+		// the first set bit of the rest.
+		void add(uint8_t* regs, uint64_t id) const
+		{
+			uint64_t h    = hash(id);
+			size_t   r    = static_cast<size_t>(h >> (64 - log2m_));
+			uint64_t rest = h << log2m_;
+			uint8_t  rank = 1;
+			while (rank <= 64 - log2m_ && !(rest & (uint64_t(1) << 63))) {
+				rest <<= 1;
+				rank++;
+			}
+			regs[r] = max(regs[r], rank);
+		}
+
+		double estimate(const uint8_t* regs) const
+		{
+			size_t m     = size_t(1) << log2m_;
+			double sum   = 0;
+			size_t zeros = 0;
+			for (size_t i = 0; i < m; i++)
+			{
+				sum += ldexp(1.0, -regs[i]);
+				zeros += regs[i] == 0;
+			}
+			double alpha = m == 16 ? 0.673 : m == 32 ? 0.697 : m == 64 ? 0.709 : 0.7213 / (1 + 1.079 / m);
+			double e     = alpha * m * m / sum;
+			if (e <= 2.5 * m && zeros)
+				e = m * log(static_cast<double>(m) / zeros); // linear counting for small sets.
+			return e;
+		}
+
+		// to = from ∪ other; returns true if to differs from from.
+		static bool merge(uint8_t* to, const uint8_t* other, size_t m)
+		{
+			bool changed = false;
+			for (size_t i = 0; i < m; i++)
+			{
+				uint8_t v = max(to[i], other[i]);
+				changed |= v != to[i];
+				to[i] = v;
+			}
+			return changed;
+		}
+	public:
+		hyperBall(const basicGraph::bGraph* graph, size_t log2m = 6, size_t maxIterations = 1000) :
+			graph_(graph), log2m_(min<size_t>(16, max<size_t>(4, log2m))), maxIterations_(maxIterations)
+		{}
+		void build()
+		{
+			size_t n = graph_->nNodes();
+			size_t m = size_t(1) << log2m_;
+			nf_.assign(1, static_cast<double>(n));
+			harmonic_.assign(n, 0);
+			if (n == 0)
+				return;
+
+			basicGraph::csrGraph in(graph_, true);
+			vector<uint8_t> cur(n * m, 0), next(n * m, 0);
+			vector<double>  size(n, 1);
+			vector<char>    changed(n, 1), nextChanged(n, 0);
+			parallel::parallel_for(0, n, [&](size_t u) { add(&cur[u * m], u); });
+
+			for (size_t t = 1; t <= maxIterations_; t++)
+			{
+				double pairs = parallel::reduce(0, n, 0.0, [&](size_t v) {
+					uint8_t* regs = &next[v * m];
+					copy(&cur[v * m], &cur[v * m] + m, regs);
+					bool grew = false;
+					for (const uint32_t* u = in.begin(v); u != in.end(v); u++)
+						if (changed[*u])
+							grew |= merge(regs, &cur[*u * m], m);
+					nextChanged[v] = grew;
+					if (grew)
+					{
+						double s = max(size[v], estimate(regs));
+						harmonic_[v] += (s - size[v]) / t;
+						size[v] = s;
+					}
+					return size[v];
+				}, plus<double>(), 256);
+
+				STATS_ADD(NODES_VISITED, n);
+				STATS_ADD(EDGES_SCANNED, in.nArcs());
+				cur.swap(next);
+				changed.swap(nextChanged);
+				if (find(changed.begin(), changed.end(), 1) == changed.end())
+					break;
+				nf_.push_back(pairs);
+			}
+		}
+
+		const vector<double>& neighborhood() const { return nf_; }
+		const vector<double>& harmonic()     const { return harmonic_; }
+		double harmonic(const basicGraph::bNode* node) const { return harmonic_[node->id()]; }
+
+		// iterations in which some ball grew.
+		size_t diameter_bound() const { return nf_.size() - 1; }
+
+		// distance within which the given fraction of reachable pairs lie.
+		double effective_diameter(double fraction = 0.9) const
+		{
+			double target = fraction * nf_.back();
+			for (size_t t = 0; t < nf_.size(); t++)
+				if (nf_[t] >= target)
+					return t == 0 ? 0.0 : (t - 1) + (target - nf_[t - 1]) / (nf_[t] - nf_[t - 1]);
+			return static_cast<double>(nf_.size() - 1);
+		}
+
+		void print(size_t k) const
+		{
+			cout << "distance pairs\n";
+			cout << "======== =====\n";
+			for (size_t t = 0; t < nf_.size(); t++)
+				cout << t << " " << nf_[t] << "\n";
+			cout << "effective diameter " << effective_diameter() << ", diameter at least "
+				<< diameter_bound() << ", " << (size_t(1) << log2m_) << " registers per node.\n";
+
+			vector<uint32_t> ids(harmonic_.size());
+			for (size_t u = 0; u < ids.size(); u++)
+				ids[u] = static_cast<uint32_t>(u);
+			k = min(k, ids.size());
+			const vector<double>& h = harmonic_;
+			partial_sort(ids.begin(), ids.begin() + k, ids.end(), [&h](uint32_t a, uint32_t b) {
+				return h[a] != h[b] ? h[a] > h[b] : a < b;
+			});
+			cout << "rank node harmonic\n";
+			cout << "==== ==== ========\n";
+			for (size_t i = 0; i < k; i++)
+				cout << i + 1 << " " << graph_->node(ids[i])->name() << " " << harmonic_[ids[i]] << "\n";
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,263 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// k-core Decomposition:
+//      The k-core is the largest subgraph in which every node has at least
+// k neighbors. Core number of a node is the largest k whose k-core holds
+// it. Edge direction, weights, self loops and parallel edges are ignored.
+//
+// Bucket peeling (Batagelj, Zaversnik), O(n + m):
+//   put nodes in buckets by degree
+//   for nodes v in increasing bucket order
+//      core(v) = degree(v)
+//      for each neighbor u with degree(u) > degree(v)
+//         move u to the bucket below, degree(u)--
+//
+//      Buckets are one array of nodes sorted by degree; moving a node one
+// bucket down is a swap with the first node of its bucket.
+//
+// Level peeling (parallel):
+//   for k = smallest remaining degree, ...
+//      frontier = remaining nodes of degree k
+//      while frontier is not empty
+//         in parallel, for v in frontier: core(v) = k, and atomically
+//         decrement degree of neighbors above k; a neighbor that falls
+//         to k joins the next frontier
+//
+// Reference: Batagelj, Zaversnik, "An O(m) Algorithm for Cores
+//            Decomposition of Networks", 2003.
+//            Kabir, Madduri, "Parallel k-Core Decomposition on Multicore
+//            Platforms", 2017.
+
+#ifndef GRAPH_KCORE_H
+#define GRAPH_KCORE_H
+
+#include "graph.h"
+#include "csr.h"
+#include "parallel.h"
+#include "stats.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+namespace cores {
+
+	class kcore {
+	private:
+		const basicGraph::bGraph* graph_;
+		vector<size_t>            offsets_; // simple undirected adjacency.
+		vector<uint32_t>          targets_;
+		vector<uint32_t>          core_;    // core number, indexed by node id.
+
+		void build_adjacency()
+		{
+			size_t n = graph_->nNodes();
+			basicGraph::csrGraph fwd(graph_);
+			unique_ptr<basicGraph::csrGraph> bwd(graph_->directed() ? new basicGraph::csrGraph(graph_, true) : nullptr);
+
+			vector<vector<uint32_t>> adj(n);
+			parallel::parallel_for(0, n, [&](size_t u) {
+				for (const uint32_t* w = fwd.begin(u); w != fwd.end(u); w++)
+					if (*w != u)
+						adj[u].push_back(*w);
+				if (bwd)
+					for (const uint32_t* w = bwd->begin(u); w != bwd->end(u); w++)
+						if (*w != u)
+							adj[u].push_back(*w);
+				sort(adj[u].begin(), adj[u].end());
+				adj[u].erase(unique(adj[u].begin(), adj[u].end()), adj[u].end());
+			}, 256);
+
+			offsets_.assign(n + 1, 0);
+			for (size_t u = 0; u < n; u++)
+				offsets_[u + 1] = offsets_[u] + adj[u].size();
+			targets_.resize(offsets_.back());
+			parallel::parallel_for(0, n, [&](size_t u) {
+				copy(adj[u].begin(), adj[u].end(), targets_.begin() + offsets_[u]);
+				vector<uint32_t>().swap(adj[u]);
+			}, 256);
+		}
+
+		void peel_buckets()
+		{
+			size_t n = graph_->nNodes();
+			size_t maxDegree = 0;
+			vector<uint32_t>& degree = core_;
+			for (size_t u = 0; u < n; u++)
+			{
+				degree[u] = static_cast<uint32_t>(offsets_[u + 1] - offsets_[u]);
+				maxDegree = max<size_t>(maxDegree, degree[u]);
+			}
+
+			// bin[d] is the start of bucket d in vert; pos[v] is v's index in vert.
+			vector<size_t>   bin(maxDegree + 2, 0);
+			vector<uint32_t> vert(n);
+			vector<size_t>   pos(n);
+			for (size_t u = 0; u < n; u++)
+				bin[degree[u] + 1]++;
+			for (size_t d = 0; d <= maxDegree; d++)
+				bin[d + 1] += bin[d];
+			vector<size_t> fill(bin.begin(), bin.end() - 1);
+			for (size_t u = 0; u < n; u++)
+			{
+				pos[u] = fill[degree[u]]++;
+				vert[pos[u]] = static_cast<uint32_t>(u);
+			}
+
+			for (size_t i = 0; i < n; i++)
+			{
+				uint32_t v = vert[i];
+				for (size_t e = offsets_[v]; e < offsets_[v + 1]; e++)
+				{
+					uint32_t u = targets_[e];
+					if (degree[u] <= degree[v])
+						continue;
+					// swap u with the first node of its bucket, then shrink the bucket.
+					size_t   du    = degree[u];
+					size_t   first = bin[du];
+					uint32_t w     = vert[first];
+					if (u != w) {
+						vert[pos[u]] = w;
+						pos[w]       = pos[u];
+						vert[first]  = u;
+						pos[u]       = first;
+					}
+					bin[du]++;
+					degree[u]--;
+				}
+			}
+			STATS_ADD(NODES_PEELED, n);
+			STATS_ADD(EDGES_SCANNED, targets_.size());
+		}
+
+		void peel_levels()
+		{
+			size_t n = graph_->nNodes();
+			unique_ptr<atomic<uint32_t>[]> degree(new atomic<uint32_t>[n]);
+			vector<bool> done(n, false);
+			parallel::parallel_for(0, n, [&](size_t u) {
+				degree[u].store(static_cast<uint32_t>(offsets_[u + 1] - offsets_[u]), memory_order_relaxed);
+			});
+
+			vector<vector<uint32_t>> next(parallel::nThreads());
+			vector<uint32_t> frontier, remaining(n);
+			for (size_t u = 0; u < n; u++)
+				remaining[u] = static_cast<uint32_t>(u);
+			while (true)
+			{
+				// next level: smallest remaining degree.
+				size_t kept = 0;
+				for (size_t i = 0; i < remaining.size(); i++)
+					if (!done[remaining[i]])
+						remaining[kept++] = remaining[i];
+				remaining.resize(kept);
+				if (remaining.empty())
+					break;
+				uint32_t k = static_cast<uint32_t>(-1);
+				for (size_t i = 0; i < remaining.size(); i++)
+					k = min(k, degree[remaining[i]].load(memory_order_relaxed));
+				frontier.clear();
+				for (size_t i = 0; i < remaining.size(); i++)
+					if (degree[remaining[i]].load(memory_order_relaxed) == k)
+						frontier.push_back(remaining[i]);
+
+				while (!frontier.empty())
+				{
+					for (size_t i = 0; i < frontier.size(); i++)
+					{
+						done[frontier[i]]  = true;
+						core_[frontier[i]] = k;
+					}
+					STATS_ADD(NODES_PEELED, frontier.size());
+					parallel::for_chunks(0, frontier.size(), [&](size_t lo, size_t hi, size_t chunk) {
+						size_t scanned = 0;
+						for (size_t i = lo; i < hi; i++)
+						{
+							uint32_t v = frontier[i];
+							scanned += offsets_[v + 1] - offsets_[v];
+							for (size_t e = offsets_[v]; e < offsets_[v + 1]; e++)
+							{
+								uint32_t u = targets_[e];
+								if (degree[u].load(memory_order_relaxed) <= k)
+									continue;
+								uint32_t old = degree[u].fetch_sub(1, memory_order_relaxed);
+								if (old == k + 1)
+									next[chunk].push_back(u);
+								else if (old <= k)
+									degree[u].fetch_add(1, memory_order_relaxed);
+							}
+						}
+						STATS_ADD(EDGES_SCANNED, scanned);
+					}, 256);
+					frontier.clear();
+					for (size_t c = 0; c < next.size(); c++)
+					{
+						frontier.insert(frontier.end(), next[c].begin(), next[c].end());
+						next[c].clear();
+					}
+				}
+			}
+		}
+	public:
+		kcore(const basicGraph::bGraph* graph) : graph_(graph)
+		{}
+		void build(bool parallelPeel = false)
+		{
+			core_.assign(graph_->nNodes(), 0);
+			build_adjacency();
+			if (parallelPeel)
+				peel_levels();
+			else
+				peel_buckets();
+			vector<size_t>().swap(offsets_);
+			vector<uint32_t>().swap(targets_);
+		}
+
+		uint32_t core(const basicGraph::bNode* node) const { return core_[node->id()]; }
+		const vector<uint32_t>& cores() const { return core_; }
+		uint32_t maxCore() const
+		{
+			return core_.empty() ? 0 : *max_element(core_.begin(), core_.end());
+		}
+
+		// subgraph on nodes with core number k or more; caller owns it.
+		basicGraph::bGraph* extract(uint32_t k) const
+		{
+			basicGraph::bGraph* sub = new basicGraph::bGraph(graph_->directed());
+			for (size_t u = 0; u < core_.size(); u++)
+				if (core_[u] >= k)
+					sub->addNode(graph_->node(u)->name());
+			set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter;
+			for (eiter = graph_->edgeBegin(); eiter != graph_->edgeEnd(); eiter++)
+			{
+				const basicGraph::bEdge* edge = *eiter;
+				if (core_[edge->n1()->id()] < k || core_[edge->n2()->id()] < k)
+					continue;
+				size_t weight = edge->hasWeight() ?
+					dynamic_cast<const basicGraph::bWeightedEdge*>(edge)->weight() : basicGraph::bEdge::INVALID_WEIGHT;
+				sub->addNodesAndEdge(edge->n1()->name(), edge->n2()->name(), weight);
+			}
+			return sub;
+		}
+
+		void print() const
+		{
+			map<uint32_t, size_t> hist;
+			for (size_t u = 0; u < core_.size(); u++)
+				hist[core_[u]]++;
+			cout << "core nodes\n";
+			cout << "==== =====\n";
+			for (map<uint32_t, size_t>::iterator it = hist.begin(); it != hist.end(); it++)
+				cout << it->first << " " << it->second << "\n";
+			cout << "max core " << maxCore() << ".\n";
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,469 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Community Detection (Louvain):
+//      Finds groups of nodes with many more edges inside than expected at
+// random, by greedily maximizing modularity
+//
+//   Q = sum over communities c of  in(c)/2m - (tot(c)/2m)^2
+//
+// where in(c) is the weight of edges inside c (counted from both ends),
+// tot(c) the total weighted degree of c and m the total edge weight.
+// Edge direction is ignored; unweighted edges have weight 1.
+//
+//   repeat                                        (levels)
+//      every node starts in its own community
+//      repeat                                     (rounds)
+//         every node picks the neighbor community with the best gain
+//            w(i, c) - k(i) * tot(c) / 2m
+//      until modularity improves by less than threshold
+//      collapse every community into one node, edges between communities
+//      are summed, edges inside become a self loop
+//   until modularity improves by less than threshold or no community merged
+//
+// Parallel local moves: nodes are split over threads in dynamic batches
+// and move right away, so later nodes see earlier moves as in sequential
+// Louvain. Community of a node and community totals are atomics; two
+// threads may decide on slightly stale totals, which costs a little
+// modularity but never correctness. Totals are summed again exactly after
+// every round, and a round that lowered modularity is undone. Weights to neighbor communities are summed in a small per
+// thread hash table.
+//
+// Reference: Blondel, Guillaume, Lambiotte, Lefebvre, "Fast unfolding of
+//            communities in large networks", 2008.
+//            Lu, Halappanavar, Kalyanaraman, "Parallel heuristics for
+//            scalable community detection", 2015.
+
+#ifndef GRAPH_LOUVAIN_H
+#define GRAPH_LOUVAIN_H
+
+#include "graph.h"
+#include "parallel.h"
+#include "stats.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+using namespace std;
+
+namespace community {
+
+	// weights of neighbor communities of one node; open addressing, reused.
+	class commTable {
+	private:
+		vector<uint32_t> keys_;
+		vector<double>   values_;
+		vector<uint32_t> used_;   // occupied slots, to clear and iterate.
+		size_t           mask_;
+	public:
+		commTable() : mask_(0) {}
+		static uint32_t empty() { return static_cast<uint32_t>(-1); }
+
+		// holds at least n keys until the next reset.
+		void reset(size_t n)
+		{
+			for (size_t i = 0; i < used_.size(); i++)
+				keys_[used_[i]] = empty();
+			used_.clear();
+			size_t size = 16;
+			while (size < 2 * n)
+				size <<= 1;
+			if (size > keys_.size()) {
+				keys_.assign(size, empty());
+				values_.resize(size);
+			}
+			mask_ = keys_.size() - 1;
+		}
+		void add(uint32_t key, double value)
+		{
+			size_t slot = (key * 2654435761u) & mask_;
+			while (keys_[slot] != key && keys_[slot] != empty())
+				slot = (slot + 1) & mask_;
+			if (keys_[slot] == empty()) {
+				keys_[slot]   = key;
+				values_[slot] = 0;
+				used_.push_back(static_cast<uint32_t>(slot));
+			}
+			values_[slot] += value;
+		}
+		double get(uint32_t key) const
+		{
+			size_t slot = (key * 2654435761u) & mask_;
+			while (keys_[slot] != key && keys_[slot] != empty())
+				slot = (slot + 1) & mask_;
+			return keys_[slot] == key ? values_[slot] : 0.0;
+		}
+		size_t   size()         const { return used_.size(); }
+		uint32_t key(size_t i)   const { return keys_[used_[i]]; }
+		double   value(size_t i) const { return values_[used_[i]]; }
+	};
+
+	class louvain {
+	private:
+		// weighted undirected graph of one level, self loops kept apart.
+		struct level {
+			vector<size_t>   offsets_;
+			vector<uint32_t> targets_;
+			vector<double>   weights_;
+			vector<double>   loop_;     // weight of self loop, counted from both ends.
+			vector<double>   strength_; // weighted degree, loop included.
+			size_t nNodes() const { return loop_.size(); }
+		};
+
+		const basicGraph::bGraph* graph_;
+		double                    threshold_;
+		size_t                    maxRounds_;
+		vector<uint32_t>          commId_;   // community of node, indexed by node id.
+		vector<size_t>            sizes_;
+		double                    modularity_;
+		size_t                    nLevels_;
+
+		// symmetric adjacency of the input graph, parallel edges summed.
+		void first_level(level& g) const
+		{
+			size_t n = graph_->nNodes();
+			g.loop_.assign(n, 0);
+			g.offsets_.assign(n + 1, 0);
+			set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter;
+			for (eiter = graph_->edgeBegin(); eiter != graph_->edgeEnd(); eiter++)
+				if ((*eiter)->n1() != (*eiter)->n2())
+				{
+					g.offsets_[(*eiter)->n1()->id() + 1]++;
+					g.offsets_[(*eiter)->n2()->id() + 1]++;
+				}
+			for (size_t u = 0; u < n; u++)
+				g.offsets_[u + 1] += g.offsets_[u];
+
+			vector<pair<uint32_t, double>> arcs(g.offsets_.back());
+			vector<size_t> fill(g.offsets_.begin(), g.offsets_.end() - 1);
+			for (eiter = graph_->edgeBegin(); eiter != graph_->edgeEnd(); eiter++)
+			{
+				const basicGraph::bEdge* edge = *eiter;
+				double w = edge->hasWeight() ?
+					static_cast<double>(dynamic_cast<const basicGraph::bWeightedEdge*>(edge)->weight()) : 1.0;
+				uint32_t u = static_cast<uint32_t>(edge->n1()->id());
+				uint32_t v = static_cast<uint32_t>(edge->n2()->id());
+				if (u == v)
+					g.loop_[u] += 2 * w;
+				else {
+					arcs[fill[u]++] = make_pair(v, w);
+					arcs[fill[v]++] = make_pair(u, w);
+				}
+			}
+
+			// sort and merge each list in place, then compact.
+			vector<size_t> kept(n + 1, 0);
+			parallel::parallel_for(0, n, [&](size_t u) {
+				size_t lo = g.offsets_[u], hi = g.offsets_[u + 1], k = lo;
+				sort(arcs.begin() + lo, arcs.begin() + hi);
+				for (size_t e = lo; e < hi; e++)
+				{
+					if (k > lo && arcs[k - 1].first == arcs[e].first)
+						arcs[k - 1].second += arcs[e].second;
+					else
+						arcs[k++] = arcs[e];
+				}
+				kept[u + 1] = k - lo;
+			}, 256);
+			for (size_t u = 0; u < n; u++)
+				kept[u + 1] += kept[u];
+			g.targets_.resize(kept.back());
+			g.weights_.resize(kept.back());
+			parallel::parallel_for(0, n, [&](size_t u) {
+				for (size_t i = 0; i < kept[u + 1] - kept[u]; i++)
+				{
+					g.targets_[kept[u] + i] = arcs[g.offsets_[u] + i].first;
+					g.weights_[kept[u] + i] = arcs[g.offsets_[u] + i].second;
+				}
+			}, 256);
+			g.offsets_.swap(kept);
+			set_strength(g);
+		}
+
+		static void set_strength(level& g)
+		{
+			g.strength_.resize(g.nNodes());
+			parallel::parallel_for(0, g.nNodes(), [&](size_t u) {
+				double k = g.loop_[u];
+				for (size_t e = g.offsets_[u]; e < g.offsets_[u + 1]; e++)
+					k += g.weights_[e];
+				g.strength_[u] = k;
+			});
+		}
+
+		static double modularity(const level& g, const vector<uint32_t>& comm, const vector<double>& tot, double m2)
+		{
+			double in = parallel::reduce(0, g.nNodes(), 0.0, [&](size_t u) {
+				double inU = g.loop_[u];
+				for (size_t e = g.offsets_[u]; e < g.offsets_[u + 1]; e++)
+					if (comm[g.targets_[e]] == comm[u])
+						inU += g.weights_[e];
+				return inU;
+			}, [](double a, double b) { return a + b; });
+			double expected = 0;
+			for (size_t c = 0; c < tot.size(); c++)
+				expected += (tot[c] / m2) * (tot[c] / m2);
+			return in / m2 - expected;
+		}
+
+		static void atomic_add(atomic<double>& target, double value)
+		{
+			double old = target.load(memory_order_relaxed);
+			while (!target.compare_exchange_weak(old, old + value, memory_order_relaxed))
+				;
+		}
+
+		// local moves on one level; q is the modularity reached, the return
+		// value what the level gained over its singleton communities.
+		double move_nodes(const level& g, vector<uint32_t>& comm, double m2, double& q)
+		{
+			size_t n = g.nNodes();
+			unique_ptr<atomic<uint32_t>[]> live(new atomic<uint32_t>[n]);
+			unique_ptr<atomic<double>[]>   tot(new atomic<double>[n]);
+			vector<double>                 exact(g.strength_);
+			comm.resize(n);
+			for (size_t u = 0; u < n; u++)
+			{
+				comm[u] = static_cast<uint32_t>(u);
+				live[u].store(comm[u], memory_order_relaxed);
+				tot[u].store(g.strength_[u], memory_order_relaxed);
+			}
+			q = modularity(g, comm, exact, m2);
+			double start = q;
+
+			vector<commTable> tables(parallel::nThreads());
+			vector<size_t>    moves(parallel::nThreads());
+			vector<uint32_t>  kept;   // communities before the round.
+			for (size_t round = 0; round < maxRounds_; round++)
+			{
+				kept = comm;
+				fill(moves.begin(), moves.end(), 0);
+				parallel::dynamic_for(0, n, [&](size_t u, size_t worker) {
+					commTable& table = tables[worker];
+					uint32_t   own   = live[u].load(memory_order_relaxed);
+					double     k     = g.strength_[u];
+					table.reset(g.offsets_[u + 1] - g.offsets_[u] + 1);
+					table.add(own, 0);
+					for (size_t e = g.offsets_[u]; e < g.offsets_[u + 1]; e++)
+						table.add(live[g.targets_[e]].load(memory_order_relaxed), g.weights_[e]);
+
+					uint32_t best     = own;
+					double   bestGain = table.get(own) - k * (tot[own].load(memory_order_relaxed) - k) / m2;
+					for (size_t i = 0; i < table.size(); i++)
+					{
+						uint32_t c = table.key(i);
+						if (c == own)
+							continue;
+						double gain = table.value(i) - k * tot[c].load(memory_order_relaxed) / m2;
+						if (gain > bestGain) {
+							best     = c;
+							bestGain = gain;
+						}
+					}
+					if (best != own) {
+						atomic_add(tot[own], -k);
+						atomic_add(tot[best], k);
+						live[u].store(best, memory_order_relaxed);
+						moves[worker]++;
+					}
+				}, 256);
+
+				// totals are summed again exactly, racing moves may have drifted.
+				size_t nMoves = 0;
+				for (size_t w = 0; w < moves.size(); w++)
+					nMoves += moves[w];
+				STATS_ADD(NODE_MOVES, nMoves);
+				STATS_ADD(NODES_VISITED, n);
+				STATS_ADD(EDGES_SCANNED, g.targets_.size());
+				fill(exact.begin(), exact.end(), 0.0);
+				for (size_t u = 0; u < n; u++)
+				{
+					comm[u] = live[u].load(memory_order_relaxed);
+					exact[comm[u]] += g.strength_[u];
+				}
+				for (size_t c = 0; c < n; c++)
+					tot[c].store(exact[c], memory_order_relaxed);
+
+				double newQ = modularity(g, comm, exact, m2);
+				if (newQ < q) {
+					comm.swap(kept);
+					break;
+				}
+				double gain = newQ - q;
+				q = newQ;
+				if (nMoves == 0 || gain < threshold_)
+					break;
+			}
+			return q - start;
+		}
+
+		// renumber communities densely, then collapse each into one node.
+		static size_t aggregate(const level& g, vector<uint32_t>& comm, level& coarse)
+		{
+			size_t n = g.nNodes();
+			vector<uint32_t> dense(n, static_cast<uint32_t>(-1));
+			size_t nComms = 0;
+			for (size_t u = 0; u < n; u++)
+			{
+				if (dense[comm[u]] == static_cast<uint32_t>(-1))
+					dense[comm[u]] = static_cast<uint32_t>(nComms++);
+				comm[u] = dense[comm[u]];
+			}
+
+			vector<size_t>   memberOffsets(nComms + 1, 0);
+			vector<uint32_t> members(n);
+			for (size_t u = 0; u < n; u++)
+				memberOffsets[comm[u] + 1]++;
+			for (size_t c = 0; c < nComms; c++)
+				memberOffsets[c + 1] += memberOffsets[c];
+			vector<size_t> fill(memberOffsets.begin(), memberOffsets.end() - 1);
+			for (size_t u = 0; u < n; u++)
+				members[fill[comm[u]]++] = static_cast<uint32_t>(u);
+
+			vector<vector<uint32_t>> targets(nComms);
+			vector<vector<double>>   weights(nComms);
+			vector<commTable>        tables(parallel::nThreads());
+			coarse.loop_.assign(nComms, 0);
+			parallel::dynamic_for(0, nComms, [&](size_t c, size_t worker) {
+				commTable& table = tables[worker];
+				size_t degree = 0;
+				for (size_t i = memberOffsets[c]; i < memberOffsets[c + 1]; i++)
+					degree += g.offsets_[members[i] + 1] - g.offsets_[members[i]];
+				table.reset(degree + 1);
+				double loop = 0;
+				for (size_t i = memberOffsets[c]; i < memberOffsets[c + 1]; i++)
+				{
+					uint32_t u = members[i];
+					loop += g.loop_[u];
+					for (size_t e = g.offsets_[u]; e < g.offsets_[u + 1]; e++)
+					{
+						uint32_t d = comm[g.targets_[e]];
+						if (d == c)
+							loop += g.weights_[e];
+						else
+							table.add(d, g.weights_[e]);
+					}
+				}
+				coarse.loop_[c] = loop;
+				for (size_t i = 0; i < table.size(); i++)
+				{
+					targets[c].push_back(table.key(i));
+					weights[c].push_back(table.value(i));
+				}
+			}, 64);
+
+			coarse.offsets_.assign(nComms + 1, 0);
+			for (size_t c = 0; c < nComms; c++)
+				coarse.offsets_[c + 1] = coarse.offsets_[c] + targets[c].size();
+			coarse.targets_.resize(coarse.offsets_.back());
+			coarse.weights_.resize(coarse.offsets_.back());
+			parallel::parallel_for(0, nComms, [&](size_t c) {
+				copy(targets[c].begin(), targets[c].end(), coarse.targets_.begin() + coarse.offsets_[c]);
+				copy(weights[c].begin(), weights[c].end(), coarse.weights_.begin() + coarse.offsets_[c]);
+			}, 256);
+			set_strength(coarse);
+			return nComms;
+		}
+	public:
+		louvain(const basicGraph::bGraph* graph, double threshold = 1e-6, size_t maxRounds = 100) :
+			graph_(graph), threshold_(threshold), maxRounds_(maxRounds), modularity_(0), nLevels_(0)
+		{}
+		void build()
+		{
+			size_t n = graph_->nNodes();
+			commId_.resize(n);
+			sizes_.clear();
+			modularity_ = 0;
+			nLevels_    = 0;
+			for (size_t u = 0; u < n; u++)
+				commId_[u] = static_cast<uint32_t>(u);
+
+			level g;
+			first_level(g);
+			double m2 = 0;
+			for (size_t u = 0; u < n; u++)
+				m2 += g.strength_[u];
+			if (m2 == 0)
+			{
+				sizes_.assign(n, 1);
+				return;
+			}
+
+			vector<uint32_t> comm;
+			while (true)
+			{
+				double q;
+				double gain = move_nodes(g, comm, m2, q);
+				if (nLevels_ == 0)
+					modularity_ = q - gain; // of the singletons.
+				// a level that merged nothing or gained nothing is dropped.
+				level coarse;
+				if (gain <= 0 || aggregate(g, comm, coarse) == g.nNodes())
+					break;
+				nLevels_++;
+				modularity_ = q;
+				parallel::parallel_for(0, n, [&](size_t u) { commId_[u] = comm[commId_[u]]; });
+				if (gain < threshold_)
+					break;
+				g = move(coarse);
+			}
+
+			// number communities by their smallest node id.
+			vector<uint32_t> dense(n, static_cast<uint32_t>(-1));
+			for (size_t u = 0; u < n; u++)
+			{
+				if (dense[commId_[u]] == static_cast<uint32_t>(-1)) {
+					dense[commId_[u]] = static_cast<uint32_t>(sizes_.size());
+					sizes_.push_back(0);
+				}
+				commId_[u] = dense[commId_[u]];
+				sizes_[commId_[u]]++;
+			}
+		}
+
+		size_t nCommunities() const { return sizes_.size(); }
+		size_t nLevels()      const { return nLevels_; }
+		double modularity()   const { return modularity_; }
+		uint32_t community(const basicGraph::bNode* node) const { return commId_[node->id()]; }
+		const vector<uint32_t>& communityIds() const { return commId_; }
+		const vector<size_t>&   sizes()        const { return sizes_; }
+
+		void print_community(uint32_t comm) const
+		{
+			cout << "Community " << comm << " : ";
+			for (size_t u = 0; u < commId_.size(); u++)
+				if (commId_[u] == comm)
+					cout << graph_->node(u)->name() << " ";
+			cout << "\n";
+		}
+		void print() const
+		{
+			vector<size_t> offsets(sizes_.size() + 1, 0);
+			for (size_t c = 0; c < sizes_.size(); c++)
+				offsets[c + 1] = offsets[c] + sizes_[c];
+			vector<uint32_t> members(commId_.size());
+			vector<size_t>   fill(offsets.begin(), offsets.end() - 1);
+			for (size_t u = 0; u < commId_.size(); u++)
+				members[fill[commId_[u]]++] = static_cast<uint32_t>(u);
+
+			for (size_t c = 0; c < sizes_.size(); c++)
+			{
+				cout << "Community " << c << " : ";
+				for (size_t i = offsets[c]; i < offsets[c + 1]; i++)
+					cout << graph_->node(members[i])->name() << " ";
+				cout << "\n";
+			}
+			print_summary();
+		}
+		void print_summary() const
+		{
+			cout << nCommunities() << " communities in " << nLevels_ << " levels, modularity "
+				<< modularity_ << ".\n";
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Node Marks:
+//      Traversal state (NOT_VISITED, VISITING, VISITED) of every node,
+// indexed by dense node id. A mark takes 2 bits; 32 marks are packed in
+// one 64 bit word. Each word carries the generation in which it was last
+// written. Words of an older generation read as all NOT_VISITED, so a
+// reset is one increment of the generation counter, not a pass over
+// all nodes.
+//
+//      Memory is 3 bits per node (2 bits of mark and 1/32 of a 32 bit
+// generation). Buffers are pooled: queries take a marks object from the
+// pool and give it back when done, so repeated queries do not allocate.
+//
+// Example:
+//       traversal::pooledMarks marks(graph->nNodes());
+//       marks->set(node->id(), basicGraph::VISITING);
+
+#ifndef GRAPH_MARKS_H
+#define GRAPH_MARKS_H
+
+#include "graph.h"
+#include <stdint.h>
+#include <mutex>
+
+using namespace std;
+
+namespace traversal {
+
+	class nodeMarks {
+	private:
+		vector<uint64_t> words_;      // 32 marks of 2 bits each.
+		vector<uint32_t> generation_; // generation of each word.
+		uint32_t         current_;    // generation of this traversal.
+	public:
+		nodeMarks() : current_(0) {}
+
+		// all marks read NOT_VISITED after reset.
+		void reset(size_t nNodes)
+		{
+			size_t nWords = (nNodes + 31) >> 5;
+			if (words_.size() < nWords) {
+				words_.resize(nWords, 0);
+				generation_.resize(nWords, 0);
+			}
+			if (++current_ == 0) { // wrapped, old generations could read as current.
+				generation_.assign(generation_.size(), 0);
+				current_ = 1;
+			}
+		}
+		basicGraph::NODE_MARKS get(size_t id) const
+		{
+			size_t w = id >> 5;
+			if (generation_[w] != current_)
+				return basicGraph::NOT_VISITED;
+			unsigned mark = static_cast<unsigned>(words_[w] >> ((id & 31) << 1)) & 3;
+			return mark ? static_cast<basicGraph::NODE_MARKS>(mark) : basicGraph::NOT_VISITED;
+		}
+		void set(size_t id, basicGraph::NODE_MARKS mark)
+		{
+			size_t   w     = id >> 5;
+			unsigned shift = static_cast<unsigned>((id & 31) << 1);
+			if (generation_[w] != current_) {
+				words_[w] = 0;
+				generation_[w] = current_;
+			}
+			words_[w] = (words_[w] & ~(uint64_t(3) << shift)) | (uint64_t(mark & 3) << shift);
+		}
+		size_t bytes() const
+		{
+			return words_.capacity() * sizeof(uint64_t) + generation_.capacity() * sizeof(uint32_t);
+		}
+	};
+
+	// process wide pool of marks, safe to use from many threads.
+	class marksPool {
+	private:
+		mutex              lock_;
+		vector<nodeMarks*> free_;
+	public:
+		nodeMarks* acquire(size_t nNodes)
+		{
+			nodeMarks* marks = nullptr;
+			{
+				lock_guard<mutex> guard(lock_);
+				if (!free_.empty()) {
+					marks = free_.back();
+					free_.pop_back();
+				}
+			}
+			if (!marks)
+				marks = new nodeMarks();
+			marks->reset(nNodes);
+			return marks;
+		}
+		void release(nodeMarks* marks)
+		{
+			lock_guard<mutex> guard(lock_);
+			free_.push_back(marks);
+		}
+		~marksPool()
+		{
+			for (size_t i = 0; i < free_.size(); i++)
+				delete free_[i];
+		}
+		static marksPool& instance()
+		{
+			static marksPool pool;
+			return pool;
+		}
+	};
+
+	// marks borrowed from the pool for the life time of this object.
+	class pooledMarks {
+	private:
+		nodeMarks* marks_;
+		pooledMarks(const pooledMarks&);
+		pooledMarks& operator=(const pooledMarks&);
+	public:
+		pooledMarks(size_t nNodes) : marks_(marksPool::instance().acquire(nNodes)) {}
+		~pooledMarks() { marksPool::instance().release(marks_); }
+		nodeMarks*       operator->()       { return marks_; }
+		const nodeMarks* operator->() const { return marks_; }
+	};
+}
+
+#endif
@@ -0,0 +1,351 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Maximum Flow and Minimum s-t Cut (push-relabel):
+//      Edge weights are capacities; unweighted edges have capacity 1 and
+// undirected edges carry flow either way. Max flow from s to t equals the
+// capacity of the smallest set of edges whose removal separates t from s.
+//
+//   preflow: saturate all edges out of s
+//   height(s) = n, height(v) = distance to t in the residual graph
+//   while some node u other than s, t has excess
+//      push excess along residual arcs (u, v) with height(u) = height(v)+1
+//      if none left, relabel: height(u) = 1 + min height of residual arcs
+//
+//      Heuristics:
+//   highest label  always discharge an active node of largest height.
+//   global relabel from time to time, set heights to exact distances to
+//                  t by a backward BFS in the residual graph. The BFS runs
+//                  level by level in parallel.
+//   gap            when no node is left at height k < n, nodes above k
+//                  can no longer reach t; they are lifted to n at once.
+//
+// Only the first phase (max preflow) is run: it gives the flow value and
+// the cut. Source side of the cut is every node that can not reach t in
+// the final residual graph.
+//
+// Reference: Goldberg, Tarjan, "A New Approach to the Maximum-Flow
+//            Problem", 1988.
+//            Cherkassky, Goldberg, "On Implementing the Push-Relabel Method
+//            for the Maximum Flow Problem", 1997.
+
+#ifndef GRAPH_MAXFLOW_H
+#define GRAPH_MAXFLOW_H
+
+#include "graph.h"
+#include "parallel.h"
+#include "stats.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+using namespace std;
+
+namespace flow {
+
+	class pushRelabel {
+	private:
+		static uint32_t none() { return static_cast<uint32_t>(-1); }
+
+		const basicGraph::bGraph* graph_;
+		const basicGraph::bNode*  source_;
+		const basicGraph::bNode*  sink_;
+		int64_t                   value_;
+
+		// residual graph: arcs of u are [first_[u], first_[u+1]).
+		vector<size_t>            first_;
+		vector<uint32_t>          head_;
+		vector<int64_t>           rcap_;
+		vector<size_t>            rev_;     // paired arc in the other direction.
+
+		vector<uint32_t>          height_;
+		vector<int64_t>           excess_;
+		vector<size_t>            current_; // next arc to try.
+
+		// nodes of each height below n: active ones in a stack, all of them
+		// in a doubly linked list for the gap heuristic.
+		vector<vector<uint32_t>>  active_;
+		vector<uint32_t>          allNext_, allPrev_, allHead_;
+		uint32_t                  maxActive_, maxAll_;
+		size_t                    work_;
+
+		void build_residual()
+		{
+			size_t n = graph_->nNodes();
+			first_.assign(n + 1, 0);
+			set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter;
+			for (eiter = graph_->edgeBegin(); eiter != graph_->edgeEnd(); eiter++)
+			{
+				if ((*eiter)->n1() == (*eiter)->n2())
+					continue;
+				first_[(*eiter)->n1()->id() + 1]++;
+				first_[(*eiter)->n2()->id() + 1]++;
+			}
+			for (size_t u = 0; u < n; u++)
+				first_[u + 1] += first_[u];
+			head_.resize(first_.back());
+			rcap_.resize(first_.back());
+			rev_.resize(first_.back());
+
+			vector<size_t> fill(first_.begin(), first_.end() - 1);
+			for (eiter = graph_->edgeBegin(); eiter != graph_->edgeEnd(); eiter++)
+			{
+				const basicGraph::bEdge* edge = *eiter;
+				uint32_t u = static_cast<uint32_t>(edge->n1()->id());
+				uint32_t v = static_cast<uint32_t>(edge->n2()->id());
+				if (u == v)
+					continue;
+				int64_t cap = edge->hasWeight() ?
+					static_cast<int64_t>(dynamic_cast<const basicGraph::bWeightedEdge*>(edge)->weight()) : 1;
+				size_t a = fill[u]++, b = fill[v]++;
+				head_[a] = v;  rcap_[a] = cap;                       rev_[a] = b;
+				head_[b] = u;  rcap_[b] = graph_->directed() ? 0 : cap; rev_[b] = a;
+			}
+		}
+
+		void all_insert(uint32_t u)
+		{
+			uint32_t h = height_[u];
+			allPrev_[u] = none();
+			allNext_[u] = allHead_[h];
+			if (allHead_[h] != none())
+				allPrev_[allHead_[h]] = u;
+			allHead_[h] = u;
+			maxAll_ = max(maxAll_, h);
+		}
+		void all_remove(uint32_t u)
+		{
+			uint32_t h = height_[u];
+			if (allPrev_[u] != none())
+				allNext_[allPrev_[u]] = allNext_[u];
+			else
+				allHead_[h] = allNext_[u];
+			if (allNext_[u] != none())
+				allPrev_[allNext_[u]] = allPrev_[u];
+		}
+		void activate(uint32_t u)
+		{
+			active_[height_[u]].push_back(u);
+			maxActive_ = max(maxActive_, height_[u]);
+		}
+
+		// exact heights by parallel backward BFS from the sink.
+		void global_relabel()
+		{
+			size_t   n = height_.size();
+			uint32_t s = static_cast<uint32_t>(source_->id()), t = static_cast<uint32_t>(sink_->id());
+			unique_ptr<atomic<uint32_t>[]> dist(new atomic<uint32_t>[n]);
+			parallel::parallel_for(0, n, [&](size_t u) { dist[u].store(static_cast<uint32_t>(n), memory_order_relaxed); });
+			dist[t].store(0, memory_order_relaxed);
+			dist[s].store(static_cast<uint32_t>(n), memory_order_relaxed);
+
+			vector<uint32_t>         frontier(1, t);
+			vector<vector<uint32_t>> next(parallel::nThreads());
+			for (uint32_t d = 1; !frontier.empty(); d++)
+			{
+				STATS_ADD(NODES_VISITED, frontier.size());
+				parallel::for_chunks(0, frontier.size(), [&](size_t lo, size_t hi, size_t chunk) {
+					for (size_t i = lo; i < hi; i++)
+					{
+						uint32_t v = frontier[i];
+						for (size_t a = first_[v]; a < first_[v + 1]; a++)
+						{
+							uint32_t u = head_[a];
+							uint32_t unseen = static_cast<uint32_t>(n);
+							if (u == s || rcap_[rev_[a]] <= 0 || dist[u].load(memory_order_relaxed) != unseen)
+								continue;
+							if (dist[u].compare_exchange_strong(unseen, d, memory_order_relaxed))
+								next[chunk].push_back(u);
+						}
+					}
+				}, 256);
+				frontier.clear();
+				for (size_t c = 0; c < next.size(); c++)
+				{
+					frontier.insert(frontier.end(), next[c].begin(), next[c].end());
+					next[c].clear();
+				}
+			}
+
+			for (size_t h = 0; h < n; h++)
+			{
+				active_[h].clear();
+				allHead_[h] = none();
+			}
+			maxActive_ = maxAll_ = 0;
+			for (size_t u = 0; u < n; u++)
+			{
+				height_[u]  = dist[u].load(memory_order_relaxed);
+				current_[u] = first_[u];
+				if (u == s || height_[u] >= n)
+					continue;
+				all_insert(static_cast<uint32_t>(u));
+				if (excess_[u] > 0 && u != t)
+					activate(static_cast<uint32_t>(u));
+			}
+			work_ = 0;
+		}
+
+		// nodes above an empty height can not reach the sink any more.
+		void gap(uint32_t empty)
+		{
+			uint32_t n = static_cast<uint32_t>(height_.size());
+			for (uint32_t h = empty + 1; h <= maxAll_; h++)
+			{
+				for (uint32_t u = allHead_[h]; u != none(); u = allNext_[u])
+					height_[u] = n;
+				allHead_[h] = none();
+				active_[h].clear();
+			}
+			maxAll_ = empty ? empty - 1 : 0;
+			maxActive_ = min(maxActive_, maxAll_);
+		}
+
+		void relabel(uint32_t u)
+		{
+			uint32_t n   = static_cast<uint32_t>(height_.size());
+			uint32_t old = height_[u];
+			uint32_t low = n;
+			STATS_INC(FLOW_RELABELS);
+			for (size_t a = first_[u]; a < first_[u + 1]; a++)
+				if (rcap_[a] > 0)
+					low = min(low, height_[head_[a]] + 1);
+			work_ += first_[u + 1] - first_[u] + 12;
+
+			all_remove(u);
+			if (allHead_[old] == none()) {
+				height_[u] = n;
+				gap(old);
+				return;
+			}
+			height_[u]  = low;
+			current_[u] = first_[u];
+			if (low < n)
+				all_insert(u);
+		}
+
+		void discharge(uint32_t u)
+		{
+			uint32_t n = static_cast<uint32_t>(height_.size());
+			uint32_t t = static_cast<uint32_t>(sink_->id());
+			while (excess_[u] > 0 && height_[u] < n)
+			{
+				if (current_[u] == first_[u + 1]) {
+					relabel(u);
+					continue;
+				}
+				size_t   a = current_[u];
+				uint32_t v = head_[a];
+				if (rcap_[a] > 0 && height_[u] == height_[v] + 1)
+				{
+					int64_t delta = min(excess_[u], rcap_[a]);
+					STATS_INC(FLOW_PUSHES);
+					if (excess_[v] == 0 && v != t)
+						activate(v);
+					rcap_[a]        -= delta;
+					rcap_[rev_[a]]  += delta;
+					excess_[u]      -= delta;
+					excess_[v]      += delta;
+				}
+				else
+					current_[u]++;
+			}
+		}
+	public:
+		pushRelabel(const basicGraph::bGraph* graph, const basicGraph::bNode* source, const basicGraph::bNode* sink) :
+			graph_(graph), source_(source), sink_(sink), value_(0), maxActive_(0), maxAll_(0), work_(0)
+		{}
+		void build()
+		{
+			size_t   n = graph_->nNodes();
+			uint32_t s = static_cast<uint32_t>(source_->id());
+			build_residual();
+			height_.assign(n, 0);
+			excess_.assign(n, 0);
+			current_.assign(first_.begin(), first_.end() - 1);
+			active_.assign(n, vector<uint32_t>());
+			allNext_.assign(n, none());
+			allPrev_.assign(n, none());
+			allHead_.assign(n, none());
+
+			for (size_t a = first_[s]; a < first_[s + 1]; a++)
+			{
+				int64_t delta = rcap_[a];
+				rcap_[a]           -= delta;
+				rcap_[rev_[a]]     += delta;
+				excess_[head_[a]]  += delta;
+				excess_[s]         -= delta;
+			}
+			global_relabel();
+
+			const size_t updateWork = 6 * n + first_.back() / 2;
+			while (true)
+			{
+				while (maxActive_ > 0 && active_[maxActive_].empty())
+					maxActive_--;
+				if (active_[maxActive_].empty())
+					break;
+				uint32_t u = active_[maxActive_].back();
+				active_[maxActive_].pop_back();
+				if (height_[u] != maxActive_ || excess_[u] <= 0)
+					continue; // stale entry, node moved since it was queued.
+				discharge(u);
+				if (work_ > updateWork)
+					global_relabel();
+			}
+			value_ = excess_[sink_->id()];
+		}
+
+		int64_t value() const { return value_; }
+
+		// source side of the minimum cut.
+		vector<bool> source_side() const
+		{
+			size_t n = height_.size();
+			vector<bool>     reaches(n, false);
+			vector<uint32_t> stack(1, static_cast<uint32_t>(sink_->id()));
+			reaches[sink_->id()] = true;
+			while (!stack.empty())
+			{
+				uint32_t v = stack.back();
+				stack.pop_back();
+				for (size_t a = first_[v]; a < first_[v + 1]; a++)
+					if (!reaches[head_[a]] && rcap_[rev_[a]] > 0)
+					{
+						reaches[head_[a]] = true;
+						stack.push_back(head_[a]);
+					}
+			}
+			reaches.flip();
+			return reaches;
+		}
+
+		vector<const basicGraph::bEdge*> cut() const
+		{
+			vector<bool> side = source_side();
+			vector<const basicGraph::bEdge*> edges;
+			set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter;
+			for (eiter = graph_->edgeBegin(); eiter != graph_->edgeEnd(); eiter++)
+			{
+				bool in1 = side[(*eiter)->n1()->id()], in2 = side[(*eiter)->n2()->id()];
+				if ((in1 && !in2) || (!graph_->directed() && in2 && !in1))
+					edges.push_back(*eiter);
+			}
+			return edges;
+		}
+
+		void print() const
+		{
+			vector<const basicGraph::bEdge*> edges = cut();
+			cout << "max flow from " << source_->name() << " to " << sink_->name() << " is " << value_ << ".\n";
+			cout << "min cut has " << edges.size() << " edges:\n";
+			for (size_t i = 0; i < edges.size(); i++)
+				edges[i]->print();
+		}
+	};
+}
+
+#endif
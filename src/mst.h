@@ -14,6 +14,7 @@
 #include <algorithm>
 #include "graph.h"
 #include "heap.h"
+#include "stats.h"
 
 using namespace std;
 
@@ -44,7 +45,7 @@ namespace MST {
 	class minTree {
 	public:
 		set<treeNode*, treeNodeCompare> tree_;
-		virtual void build() = 0;
+		virtual void build(ostream& err = cerr) = 0;
 		bool nodePartOfMST(const basicGraph::bNode* gnode)
 		{
             treeNode tmpTreeNode = treeNode(gnode);
@@ -56,22 +57,39 @@ namespace MST {
 			set<treeNode*, treeNodeCompare>::iterator niter = tree_.find(&tmpTreeNode);
 			return niter == tree_.end() ? nullptr : *niter;
 		}
-		void print(bool edges_only=false)
+		void print(bool edges_only=false, ostream& out = cout)
 		{
+			output::writer writer(out);
+			print(edges_only, writer);
+		}
+		// the root has parent "root" in text and an empty parent in csv and binary.
+		void print(bool edges_only, output::writer& out)
+		{
+			out.header("parent,node,weight");
 			set<treeNode*, treeNodeCompare>::iterator niter = tree_.begin();
 			for (; niter != tree_.end(); niter++)
 			{
 				treeNode* tnode = (*niter);
-				if (!edges_only || tnode->parent_)
-				{
-					cout << (tnode->parent_ ? tnode->parent_->node_->name() : "root") << " "
-						<< tnode->node_->name() << " "
-						<< tnode->weight_;
-					//				cout << " (set " << tnode->iset_ << ")";
-					cout << "\n";
+				if (edges_only && !tnode->parent_)
+					continue;
+				if (!out.text()) {
+					out.field(tnode->parent_ ? tnode->parent_->node_->name().c_str() : "")
+						.field(tnode->node_->name()).field(tnode->weight_).end_record();
+					continue;
 				}
+				if (tnode->parent_)
+					out << tnode->parent_->node_->name();
+				else
+					out << "root";
+				out << ' ' << tnode->node_->name() << ' ' << tnode->weight_ << '\n';
 			}
 		}
+		// bytes of the tree nodes and their set, see footprint.h.
+		void memory(footprint::report& usage) const
+		{
+			usage.add("tree_nodes", tree_.size(), tree_.size() * footprint::heap_block(sizeof(treeNode)));
+			usage.add("tree_set",   tree_.size(), tree_.size() * footprint::tree_node_bytes<treeNode*>());
+		}
 		~minTree()
 		{
 			set<treeNode*, treeNodeCompare>::iterator niter = tree_.begin();
@@ -113,6 +131,7 @@ namespace MST {
 		// TODO: complexity is linear. Can be reduced to logarithmic
 		void unionSet(treeNode* u, treeNode* v, size_t wt, bool directed)
 		{
+			STATS_INC(UNION_CALLS);
 			size_t v_iset      = v->iset_;
 			set<treeNode*, treeNodeCompare>::iterator niter = tree_.begin();
 			for (; niter != tree_.end(); niter++)
@@ -141,21 +160,26 @@ namespace MST {
 		~kruskal()
 		{}
 
-		// build MST.
-		void build()
+		// build MST. Errors and warnings go to err.
+		void build(ostream& err = cerr)
 		{
 			if (!graph_)
 			{
-				cerr << "Error: graph not found.";
+				err << "Error: graph not found.";
 				return;
 			}			if (graph_->nNodes() == 0)
 			{
-				cerr << "Error: no nodes found in the graph.";
+				err << "Error: no nodes found in the graph.";
+				return;
+			}
+			if (!graph_->weighted())
+			{
+				err << "Error: minimum spanning tree needs a weight on every edge.\n";
 				return;
 			}
 
 			if (graph_->directed())
-				cerr << "Warning: Kruskal's algorithm may produce invalid tree or \n" 
+				err << "Warning: Kruskal's algorithm may produce invalid tree or \n" 
 					 << "         more than one spanning multitree on directed graphs.\n";
 
 
@@ -183,6 +207,7 @@ namespace MST {
                 treeNode tmpVNode = treeNode(v);
 				auto uset = tree_.find(&tmpUNode);
 				auto vset = tree_.find(&tmpVNode);
+				STATS_ADD(FIND_CALLS, 2);
 				if (uset != tree_.end() && vset != tree_.end() && 
 					(*uset)->iset_ != (*vset)->iset_ )
 				{
@@ -232,8 +257,9 @@ namespace MST {
 		void addEdgesToHeap(const basicGraph::bNode* node,
 			Heap<const basicGraph::bWeightedEdge*, basicGraph::edgeCompare>& minEdgeHeap)
 		{
-			set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter = node->edgeBegin();
+			basicGraph::bNode::edgeIterator eiter = node->edgeBegin();
 			for (; eiter != node->edgeEnd(); eiter++) {
+				STATS_INC(EDGES_SCANNED);
 				if (! nodePartOfMST((*eiter)->n1()) || !nodePartOfMST((*eiter)->n2()) )
 					minEdgeHeap.push(dynamic_cast<const basicGraph::bWeightedEdge*>(*eiter));
 			}
@@ -241,22 +267,27 @@ namespace MST {
 	public:
 		prim(const basicGraph::bGraph* graph) : minTree(), graph_(graph)
 		{}
-		// build MST.
-		void build()
+		// build MST. Errors and warnings go to err.
+		void build(ostream& err = cerr)
 		{
 			if (!graph_)
 			{
-				cerr << "Error: graph not found.";
+				err << "Error: graph not found.";
 				return;
 			}
 			if (graph_->nNodes() == 0)
 			{
-				cerr << "Error: no nodes found in the graph.";
+				err << "Error: no nodes found in the graph.";
+				return;
+			}
+			if (!graph_->weighted())
+			{
+				err << "Error: minimum spanning tree needs a weight on every edge.\n";
 				return;
 			}
 			if (graph_->directed())
 			{
-				cerr << "Warning: Prim's algorithm may produce invalid tree or \n"
+				err << "Warning: Prim's algorithm may produce invalid tree or \n"
 					<< "         more than one spanning multitree on directed graphs.\n";
 			}
 
@@ -266,6 +297,7 @@ namespace MST {
 			set<const basicGraph::bNode*, basicGraph::nodeCompare>::iterator niter = graph_->nodeBegin();
 			const basicGraph::bNode* node = *niter;
 			tree_.insert(new treeNode(node, 0));
+			STATS_INC(NODES_SETTLED);
 
 			// Grow the tree by one edge : of the edges that connect the tree
 			// to vertices not yet in the tree, find the minimum - weight edge, 
@@ -282,6 +314,7 @@ namespace MST {
 				{
 					tn2 = new treeNode(minEdge->n2());
 					tree_.insert(tn2);
+					STATS_INC(NODES_SETTLED);
 					tn1->setParent(tn2, minEdge->weight());
 					addEdgesToHeap(tn2->node_, minEdgeHeap);
 				}
@@ -289,6 +322,7 @@ namespace MST {
 				{
 					tn1 = new treeNode(minEdge->n1());
 					tree_.insert(tn1);
+					STATS_INC(NODES_SETTLED);
 					tn2->setParent(tn1, minEdge->weight());
 					addEdgesToHeap(tn1->node_, minEdgeHeap);
 				}
@@ -0,0 +1,419 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Parallel primitives:
+//      Fork-join loops of the multi-core engines, run by one shared
+// work-stealing scheduler. The pool starts on the first parallel loop with
+// nThreads()-1 threads; the calling thread works too.
+//
+// Scheduler: every thread has its own deque of tasks, a task being a
+// subrange of one loop. A thread splits its range in halves down to the
+// grain size, pushes the right halves on the back of its deque and runs
+// the left one; it takes more work from the back of its own deque (most
+// recent, still in cache) and steals from the front of other deques (the
+// oldest, largest ranges). A thread waiting for its loop to finish only
+// runs tasks of that loop, so nested loops (a parallel engine inside a
+// batch query) neither deadlock nor interleave unrelated work.
+//
+//   parallel_for   body(i) for i in [begin, end), split down to grain.
+//   for_chunks     body(lo, hi, chunk), one contiguous chunk per thread;
+//                  chunk in [0, nThreads()) indexes per chunk scratch.
+//   dynamic_for    body(i, worker), batches handed out from a counter.
+//   reduce         combine of body(i) over [begin, end), in index order,
+//                  grouped in fixed blocks; same result for any threads.
+//   exclusive_scan prefix combine of in[0, n) to out, returns the total.
+//
+// Worker count: setThreads(n) before the first loop, e.g. from --threads,
+// else environment variable BGA_THREADS, else hardware_concurrency().
+//
+// Example:
+//       parallel::parallel_for(0, n, [&](size_t i) { out[i] = f(in[i]); });
+//
+// Reference: Blumofe, Leiserson, "Scheduling Multithreaded Computations by
+//            Work Stealing", 1999.
+
+#ifndef GRAPH_PARALLEL_H
+#define GRAPH_PARALLEL_H
+
+#include <thread>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+
+namespace parallel {
+
+	// workers asked for; 0 until set or first read.
+	inline std::atomic<size_t>& requested()
+	{
+		static std::atomic<size_t> n(0);
+		return n;
+	}
+	inline std::atomic<bool>& started()
+	{
+		static std::atomic<bool> s(false);
+		return s;
+	}
+
+	// sets the worker count; false once the first loop has run.
+	inline bool setThreads(size_t n)
+	{
+		if (n == 0 || started().load())
+			return false;
+		requested().store(n);
+		return true;
+	}
+
+	inline size_t nThreads()
+	{
+		static const size_t n = []() {
+			size_t threads = requested().load();
+			const char* env = std::getenv("BGA_THREADS");
+			if (threads == 0 && env)
+				threads = std::strtoul(env, nullptr, 10);
+			if (threads == 0)
+				threads = std::thread::hardware_concurrency();
+			started().store(true);
+			return std::max<size_t>(1, threads);
+		}();
+		return n;
+	}
+
+	class scheduler {
+	private:
+		// a parallel loop over [begin, end) waiting on the stack of its caller.
+		struct job {
+			void (*run_)(void* body, size_t lo, size_t hi);
+			void*               body_;
+			size_t              grain_;
+			std::atomic<size_t> remaining_; // iterations not yet run.
+		};
+		struct task {
+			job*   job_;
+			size_t lo_;
+			size_t hi_;
+		};
+		// deque of one thread, locked by a spin flag (held for a few instructions).
+		struct queue {
+			std::atomic_flag busy_;
+			std::deque<task> tasks_;
+			char             pad_[64];  // keeps flags of neighbor queues off one cache line.
+			queue() { busy_.clear(); }
+			void lock()   { while (busy_.test_and_set(std::memory_order_acquire)) std::this_thread::yield(); }
+			void unlock() { busy_.clear(std::memory_order_release); }
+		};
+
+		static size_t maxQueues() { return 256; }
+
+		queue*                   queues_;   // never freed, see instance().
+		std::atomic<size_t>      nQueues_;  // queues handed out so far.
+		std::mutex               lock_;     // guards free_ and sleeping.
+		std::vector<size_t>      free_;     // queues of threads that exited.
+		std::condition_variable  wake_;
+		std::atomic<size_t>      queued_;   // tasks in all queues.
+		std::atomic<size_t>      sleepers_;
+
+		// queue of the calling thread; queue 0 is shared once all are taken.
+		struct slot {
+			size_t index_;
+			slot() : index_(instance().acquire()) {}
+			~slot() { instance().release(index_); }
+		};
+		size_t acquire()
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			if (!free_.empty()) {
+				size_t index = free_.back();
+				free_.pop_back();
+				return index;
+			}
+			size_t index = nQueues_.load();
+			if (index >= maxQueues())
+				return 0;
+			nQueues_.store(index + 1);
+			return index;
+		}
+		void release(size_t index)
+		{
+			if (index == 0)
+				return;
+			std::lock_guard<std::mutex> guard(lock_);
+			free_.push_back(index);
+		}
+		queue& own()
+		{
+			static thread_local slot s;
+			return queues_[s.index_];
+		}
+
+		void push(queue& q, const task& t)
+		{
+			q.lock();
+			q.tasks_.push_back(t);
+			q.unlock();
+			queued_.fetch_add(1);
+			if (sleepers_.load() > 0) {
+				std::lock_guard<std::mutex> guard(lock_);
+				wake_.notify_one();
+			}
+		}
+		// back of the own queue; only a task of j unless j is null.
+		bool pop(queue& q, task& t, const job* j)
+		{
+			q.lock();
+			bool found = !q.tasks_.empty() && (!j || q.tasks_.back().job_ == j);
+			if (found) {
+				t = q.tasks_.back();
+				q.tasks_.pop_back();
+			}
+			q.unlock();
+			if (found)
+				queued_.fetch_sub(1);
+			return found;
+		}
+		// front of another queue; only a task of j unless j is null.
+		bool steal(task& t, const job* j)
+		{
+			static thread_local size_t seed = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+			size_t n = nQueues_.load();
+			seed ^= seed << 13;
+			seed ^= seed >> 7;
+			seed ^= seed << 17;
+			for (size_t k = 0, first = seed % n; k < n; k++)
+			{
+				queue& q = queues_[(first + k) % n];
+				q.lock();
+				bool found = !q.tasks_.empty() && (!j || q.tasks_.front().job_ == j);
+				if (found) {
+					t = q.tasks_.front();
+					q.tasks_.pop_front();
+				}
+				q.unlock();
+				if (found) {
+					queued_.fetch_sub(1);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// splits t down to the grain, keeping the left half, and runs it.
+		void execute(task t)
+		{
+			job*   j  = t.job_;
+			queue& q  = own();
+			size_t lo = t.lo_, hi = t.hi_;
+			while (hi - lo > j->grain_)
+			{
+				size_t mid = lo + (hi - lo) / 2;
+				task right = { j, mid, hi };
+				push(q, right);
+				hi = mid;
+			}
+			j->run_(j->body_, lo, hi);
+			j->remaining_.fetch_sub(hi - lo, std::memory_order_acq_rel); // last touch of j.
+		}
+
+		void work()
+		{
+			queue& q = own();
+			task t;
+			while (true)
+			{
+				if (pop(q, t, nullptr) || steal(t, nullptr)) {
+					execute(t);
+					continue;
+				}
+				std::unique_lock<std::mutex> guard(lock_);
+				sleepers_.fetch_add(1);
+				if (queued_.load() == 0)
+					wake_.wait_for(guard, std::chrono::milliseconds(50));
+				sleepers_.fetch_sub(1);
+			}
+		}
+
+		scheduler() : queues_(new queue[maxQueues()]), nQueues_(1), queued_(0), sleepers_(0)
+		{}
+		void start()
+		{
+			for (size_t w = 1; w < nThreads(); w++)
+				std::thread([this]() { work(); }).detach();
+		}
+
+		template <class BODY>
+		static void run_range(void* body, size_t lo, size_t hi)
+		{
+			(*static_cast<BODY*>(body))(lo, hi);
+		}
+	public:
+		// one pool per process, started on first use and left running until
+		// exit: threads of a pool destroyed with the statics could still be
+		// counting into stats blocks or touching the queues.
+		static scheduler& instance()
+		{
+			static scheduler* pool = []() {
+				scheduler* s = new scheduler();
+				s->start();
+				return s;
+			}();
+			return *pool;
+		}
+
+		// body(lo, hi) over subranges of [begin, end) of at most grain
+		// iterations; returns when all have run.
+		template <class BODY>
+		void run(size_t begin, size_t end, BODY& body, size_t grain)
+		{
+			job j;
+			j.run_   = &run_range<BODY>;
+			j.body_  = &body;
+			j.grain_ = std::max<size_t>(1, grain);
+			j.remaining_.store(end - begin);
+			task root = { &j, begin, end };
+			execute(root);
+
+			queue& q = own();
+			task t;
+			for (size_t idle = 0; j.remaining_.load(std::memory_order_acquire) > 0; )
+			{
+				if (pop(q, t, &j) || steal(t, &j)) {
+					execute(t);
+					idle = 0;
+				}
+				else if (++idle < 64)
+					std::this_thread::yield();
+				else
+					std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		}
+	};
+
+	// body(lo, hi, chunk) is called once per chunk, chunk is in [0, nThreads()).
+	template <class BODY>
+	void for_chunks(size_t begin, size_t end, BODY body, size_t grain = 1024)
+	{
+		size_t n = end > begin ? end - begin : 0;
+		if (n == 0)
+			return;
+		grain = std::max<size_t>(1, grain);
+		size_t nChunks = std::min(nThreads(), (n + grain - 1) / grain);
+		if (nChunks <= 1) {
+			body(begin, end, 0);
+			return;
+		}
+
+		size_t chunk = (n + nChunks - 1) / nChunks;
+		auto chunks = [&body, begin, end, chunk](size_t first, size_t last) {
+			for (size_t c = first; c < last; c++)
+			{
+				size_t lo = begin + c * chunk;
+				size_t hi = std::min(end, lo + chunk);
+				if (lo < hi)
+					body(lo, hi, c);
+			}
+		};
+		scheduler::instance().run(0, nChunks, chunks, 1);
+	}
+
+	// body(i) is called for every i in [begin, end).
+	template <class BODY>
+	void parallel_for(size_t begin, size_t end, BODY body, size_t grain = 1024)
+	{
+		size_t n = end > begin ? end - begin : 0;
+		grain = std::max<size_t>(1, grain);
+		if (n <= grain || nThreads() == 1) {
+			for (size_t i = begin; i < end; i++)
+				body(i);
+			return;
+		}
+		auto range = [&body](size_t lo, size_t hi) {
+			for (size_t i = lo; i < hi; i++)
+				body(i);
+		};
+		scheduler::instance().run(begin, end, range, grain);
+	}
+
+	// body(i, worker) is called for every i in [begin, end); idle workers
+	// take the next batch of iterations, worker is in [0, nThreads()).
+	template <class BODY>
+	void dynamic_for(size_t begin, size_t end, BODY body, size_t batch = 64)
+	{
+		size_t n = end > begin ? end - begin : 0;
+		if (n == 0)
+			return;
+		batch = std::max<size_t>(1, batch);
+		std::atomic<size_t> next(begin);
+		size_t nWorkers = std::min(nThreads(), (n + batch - 1) / batch);
+		for_chunks(0, nWorkers, [&](size_t, size_t, size_t worker) {
+			size_t lo;
+			while ((lo = next.fetch_add(batch)) < end)
+				for (size_t i = lo; i < std::min(end, lo + batch); i++)
+					body(i, worker);
+		}, 1);
+	}
+
+	// combine(...combine(combine(identity, body(begin)), body(begin+1))...),
+	// grouped in blocks of grain indices: each block is combined on its own,
+	// then the blocks in index order. The grouping depends on grain only, not
+	// on the number of threads, so even a floating point sum comes out the
+	// same for every thread count (combine must be associative up to that
+	// grouping).
+	template <class T, class BODY, class COMBINE>
+	T reduce(size_t begin, size_t end, T identity, BODY body, COMBINE combine, size_t grain = 1024)
+	{
+		size_t n = end > begin ? end - begin : 0;
+		grain = std::max<size_t>(1, grain);
+		std::vector<T> partial((n + grain - 1) / grain, identity);
+		parallel_for(0, partial.size(), [&](size_t block) {
+			size_t lo = begin + block * grain, hi = std::min(end, lo + grain);
+			T acc = identity;
+			for (size_t i = lo; i < hi; i++)
+				acc = combine(acc, body(i));
+			partial[block] = acc;
+		}, 1);
+		T total = identity;
+		for (size_t b = 0; b < partial.size(); b++)
+			total = combine(total, partial[b]);
+		return total;
+	}
+
+	// out[i] = combine of in[0, i), out[0] = identity; in and out may be the
+	// same array. Returns the combine of all of in. Blocks of grain elements
+	// as in reduce, so the result does not depend on the number of threads.
+	template <class T, class COMBINE>
+	T exclusive_scan(const T* in, T* out, size_t n, T identity, COMBINE combine, size_t grain = 1 << 14)
+	{
+		grain = std::max<size_t>(1, grain);
+		size_t nBlocks = (n + grain - 1) / grain;
+		std::vector<T> partial(nBlocks + 1, identity);
+		// block totals, their prefix, then each block from its prefix.
+		parallel_for(0, nBlocks, [&](size_t block) {
+			T acc = identity;
+			for (size_t i = block * grain; i < std::min(n, (block + 1) * grain); i++)
+				acc = combine(acc, in[i]);
+			partial[block + 1] = acc;
+		}, 1);
+		for (size_t b = 1; b < partial.size(); b++)
+			partial[b] = combine(partial[b - 1], partial[b]);
+		parallel_for(0, nBlocks, [&](size_t block) {
+			T acc = partial[block];
+			for (size_t i = block * grain; i < std::min(n, (block + 1) * grain); i++)
+			{
+				T x = in[i];
+				out[i] = acc;
+				acc = combine(acc, x);
+			}
+		}, 1);
+		return partial.back();
+	}
+}
+
+#endif
@@ -0,0 +1,366 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Node and Edge Properties:
+//      Features of nodes and edges kept as typed columns, one contiguous
+// array per column indexed by dense node or edge id, so a feature join is
+// array indexing and a column scan runs over plain memory.
+//
+//   int    64 bit integers, INT_MISSING where not given.
+//   real   doubles, NaN where not given.
+//   label  strings, stored as 32 bit codes into a table of distinct
+//          labels; code 0 is the empty label, for not given.
+//
+// Columns load from a sidecar file, by default the graph file name with
+// ".props" appended. A header line starts a column, the lines after it
+// give values by node name, or by the two node names of an edge (either
+// order in undirected graphs; parallel edges all get the value). Values
+// have no spaces; empty lines and lines starting with '#' are skipped.
+//
+//    node age int
+//    n1 34
+//    n2 27
+//    edge latency real
+//    n1 n2 0.5
+//
+// An int or real edge column can replace the edge weights of dijkstra
+// (path ... weight <column>); edges without a value keep their weight. A
+// real column runs dijkstra on double distances, so fractions are kept.
+//
+// Example:
+//       properties::store props;
+//       props.load("graph.txt.props", graph);
+//       const properties::column* age = props.nodes().find("age");
+//       if (age && age->has(node->id())) cout << age->ints()[node->id()];
+
+#ifndef GRAPH_PROPERTIES_H
+#define GRAPH_PROPERTIES_H
+
+#include "graph.h"
+#include "footprint.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace properties {
+
+	enum type { INT, REAL, LABEL };
+
+	static const int64_t INT_MISSING = numeric_limits<int64_t>::min();
+
+	// type named int, real or label; false if the name is none of them.
+	inline bool parse_type(const string& name, type& t)
+	{
+		if (name == "int")        t = INT;
+		else if (name == "real")  t = REAL;
+		else if (name == "label") t = LABEL;
+		else return false;
+		return true;
+	}
+	inline const char* type_name(type t)
+	{
+		static const char* names[] = { "int", "real", "label" };
+		return names[t];
+	}
+
+	class column {
+	private:
+		string                           name_;
+		type                             type_;
+		vector<int64_t>                  ints_;   // INT values.
+		vector<double>                   reals_;  // REAL values.
+		vector<uint32_t>                 codes_;  // LABEL values, index into labels_.
+		vector<string>                   labels_; // distinct labels, labels_[0] is "".
+		unordered_map<string, uint32_t>  codeOf_; // label to its code.
+	public:
+		column(const string& name, type t, size_t rows) : name_(name), type_(t)
+		{
+			if (t == INT)
+				ints_.assign(rows, INT_MISSING);
+			else if (t == REAL)
+				reals_.assign(rows, numeric_limits<double>::quiet_NaN());
+			else {
+				codes_.assign(rows, 0);
+				labels_.push_back("");
+				codeOf_[""] = 0;
+			}
+		}
+
+		const string& name() const { return name_; }
+		type          kind() const { return type_; }
+		size_t        rows() const { return type_ == INT ? ints_.size() : type_ == REAL ? reals_.size() : codes_.size(); }
+		bool          numeric() const { return type_ != LABEL; }
+
+		// value of row, parsed from text; false if text is not of the column type.
+		bool set(size_t row, const string& text)
+		{
+			if (row >= rows() || text.empty())
+				return false;
+			char* end = nullptr;
+			errno = 0;
+			if (type_ == INT) {
+				long long v = strtoll(text.c_str(), &end, 10);
+				if (*end || errno || v == INT_MISSING)
+					return false;
+				ints_[row] = v;
+			}
+			else if (type_ == REAL) {
+				double v = strtod(text.c_str(), &end);
+				if (*end || errno || v != v)
+					return false;
+				reals_[row] = v;
+			}
+			else {
+				unordered_map<string, uint32_t>::iterator code = codeOf_.find(text);
+				if (code == codeOf_.end()) {
+					code = codeOf_.insert(make_pair(text, static_cast<uint32_t>(labels_.size()))).first;
+					labels_.push_back(text);
+				}
+				codes_[row] = code->second;
+			}
+			return true;
+		}
+
+		bool has(size_t row) const
+		{
+			if (row >= rows())
+				return false;
+			if (type_ == INT)  return ints_[row] != INT_MISSING;
+			if (type_ == REAL) return reals_[row] == reals_[row];
+			return codes_[row] != 0;
+		}
+
+		// the arrays, rows() long.
+		const int64_t*  ints()   const { return ints_.data();  }
+		const double*   reals()  const { return reals_.data(); }
+		const uint32_t* codes()  const { return codes_.data(); }
+		const string&   label(uint32_t code) const { return labels_[code]; }
+		size_t          nLabels() const { return labels_.size(); }
+
+		// value of a numeric row as a double.
+		double number(size_t row) const
+		{
+			return type_ == INT ? static_cast<double>(ints_[row]) : reals_[row];
+		}
+		// smallest value of a numeric column, 0 if it has none.
+		double minimum() const
+		{
+			double least = 0;
+			bool any = false;
+			for (size_t row = 0; row < rows(); row++)
+			{
+				if (!has(row)) continue;
+				least = any ? min(least, number(row)) : number(row);
+				any = true;
+			}
+			return least;
+		}
+
+		void print_value(size_t row, ostream& out) const
+		{
+			if (!has(row))
+				out << "-";
+			else if (type_ == INT)
+				out << ints_[row];
+			else if (type_ == REAL)
+				out << reals_[row];
+			else
+				out << labels_[codes_[row]];
+		}
+
+		// bytes of the arrays and labels, see footprint.h.
+		void memory(footprint::report& usage) const
+		{
+			size_t bytes = footprint::vector_bytes(ints_) + footprint::vector_bytes(reals_) +
+				footprint::vector_bytes(codes_) + footprint::vector_bytes(labels_);
+			for (size_t i = 0; i < labels_.size(); i++)
+				bytes += footprint::string_bytes(labels_[i]);
+			bytes += codeOf_.size() * footprint::heap_block(2 * sizeof(void*) + sizeof(pair<const string, uint32_t>)) +
+				footprint::heap_block(codeOf_.bucket_count() * sizeof(void*));
+			usage.add(name_, rows(), bytes);
+		}
+	};
+
+	// columns of one kind of element, nodes or edges.
+	class table {
+	private:
+		vector<column> columns_;
+	public:
+		size_t        size() const { return columns_.size(); }
+		const column& at(size_t i) const { return columns_[i]; }
+
+		const column* find(const string& name) const
+		{
+			for (size_t i = 0; i < columns_.size(); i++)
+				if (columns_[i].name() == name)
+					return &columns_[i];
+			return nullptr;
+		}
+		// new column, or nullptr if one is already named so.
+		column* add(const string& name, type t, size_t rows)
+		{
+			if (find(name))
+				return nullptr;
+			columns_.push_back(column(name, t, rows));
+			return &columns_.back();
+		}
+		void memory(footprint::report& usage) const
+		{
+			for (size_t i = 0; i < columns_.size(); i++)
+				columns_[i].memory(usage);
+		}
+	};
+
+	class store {
+	private:
+		table nodes_;
+		table edges_;
+
+		// ids of the edges from a to b; b to a as well in undirected graphs.
+		static void find_edges(const basicGraph::bGraph* graph, const basicGraph::bNode* a,
+			const basicGraph::bNode* b, vector<size_t>& ids)
+		{
+			ids.clear();
+			basicGraph::bNode::edgeIterator eiter;
+			for (eiter = a->edgeBegin(); eiter != a->edgeEnd(); eiter++)
+			{
+				const basicGraph::bEdge* e = *eiter;
+				if ((e->n1() == a && e->n2() == b) || (!graph->directed() && e->n1() == b && e->n2() == a))
+					ids.push_back(e->id());
+			}
+		}
+	public:
+		const table& nodes() const { return nodes_; }
+		const table& edges() const { return edges_; }
+		bool empty() const { return nodes_.size() == 0 && edges_.size() == 0; }
+
+		// reads the columns of file over the ids of graph, replacing the
+		// current ones; lines in error are reported and skipped.
+		bool load(const string& file, const basicGraph::bGraph* graph, ostream& err = cerr)
+		{
+			ifstream in(file.c_str());
+			if (!in) {
+				err << "Error: could not open file " << file << ".\n";
+				return false;
+			}
+			table nodes, edges;
+			column* current = nullptr;
+			bool onEdges = false;
+			vector<size_t> rows;
+			string line;
+			for (size_t lineNo = 1; getline(in, line); lineNo++)
+			{
+				if (!line.empty() && line[line.size() - 1] == '\r')
+					line.erase(line.size() - 1);
+				vector<string> tokens;
+				istringstream stokens(line);
+				string token;
+				while (stokens >> token)
+					tokens.push_back(token);
+				if (tokens.empty() || tokens[0][0] == '#')
+					continue;
+
+				type t;
+				if ((tokens[0] == "node" || tokens[0] == "edge") && tokens.size() == 3 && parse_type(tokens[2], t))
+				{
+					onEdges = tokens[0] == "edge";
+					current = onEdges ?
+						edges.add(tokens[1], t, graph->nEdges()) :
+						nodes.add(tokens[1], t, graph->nNodes());
+					if (!current)
+						err << "Error: line " << lineNo << ": column " << tokens[1] << " defined twice.\n";
+					continue;
+				}
+				if (!current) {
+					if (tokens[0] == "node" || tokens[0] == "edge")
+						err << "Error: line " << lineNo << ": invalid column header, types are int, real and label.\n";
+					else
+						err << "Error: line " << lineNo << ": value before any column header.\n";
+					continue;
+				}
+				if (tokens.size() != (onEdges ? 3u : 2u)) {
+					err << "Error: line " << lineNo << ": expected " << (onEdges ? "two nodes" : "a node") << " and a value.\n";
+					continue;
+				}
+
+				basicGraph::bGraph* g = const_cast<basicGraph::bGraph*>(graph); // findNode is not const.
+				const basicGraph::bNode* n1 = g->findNode(tokens[0]);
+				const basicGraph::bNode* n2 = onEdges ? g->findNode(tokens[1]) : nullptr;
+				if (!n1 || (onEdges && !n2)) {
+					err << "Error: line " << lineNo << ": node " << (n1 ? tokens[1] : tokens[0]) << " not found in the graph.\n";
+					continue;
+				}
+				if (onEdges) {
+					find_edges(graph, n1, n2, rows);
+					if (rows.empty()) {
+						err << "Error: line " << lineNo << ": edge " << tokens[0] << " " << tokens[1] << " not found in the graph.\n";
+						continue;
+					}
+				}
+				else
+					rows.assign(1, n1->id());
+				for (size_t i = 0; i < rows.size(); i++)
+				{
+					if (current->set(rows[i], tokens.back()))
+						continue;
+					err << "Error: line " << lineNo << ": " << tokens.back() << " is not a value of type "
+						<< type_name(current->kind()) << ".\n";
+					break;
+				}
+			}
+			nodes_ = nodes;
+			edges_ = edges;
+			return true;
+		}
+
+		// columns with their type and number of values.
+		void print(ostream& out = cout) const
+		{
+			out << "element column type values\n";
+			out << "======= ====== ==== ======\n";
+			for (int kind = 0; kind < 2; kind++)
+			{
+				const table& columns = kind ? edges_ : nodes_;
+				for (size_t i = 0; i < columns.size(); i++)
+				{
+					const column& c = columns.at(i);
+					size_t values = 0;
+					for (size_t row = 0; row < c.rows(); row++)
+						values += c.has(row);
+					out << (kind ? "edge " : "node ") << c.name() << " " << type_name(c.kind()) << " " << values << "\n";
+				}
+			}
+		}
+		// every node column of one node.
+		void print_node(const basicGraph::bNode* node, ostream& out = cout) const
+		{
+			out << "column value\n";
+			out << "====== =====\n";
+			for (size_t i = 0; i < nodes_.size(); i++)
+			{
+				out << nodes_.at(i).name() << " ";
+				nodes_.at(i).print_value(node->id(), out);
+				out << "\n";
+			}
+		}
+		void memory(footprint::report& usage) const
+		{
+			nodes_.memory(usage);
+			edges_.memory(usage);
+		}
+	};
+
+	// sidecar file of a graph file.
+	inline string sidecar(const string& graphFile) { return graphFile + ".props"; }
+}
+
+#endif
@@ -0,0 +1,468 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Queries:
+//      Read-only commands shared by the interactive prompt and the batch
+// mode: scc, cc, search, sort, mst and path. A query only reads the graph
+// and keeps its state local, so many queries may run at once on one
+// graph. Results are written to out, in text, csv or binary (see
+// resultWriter.h), and errors to err.
+//
+// Batch mode:
+//      One query per line, in the syntax of the prompt; empty lines and
+// lines starting with '#' are skipped. Queries are read in windows; the
+// queries of a window run concurrently, idle workers taking the next
+// query, and their results are written in input order. While one window
+// is being written, the next one is computed.
+//
+//   json  one object per line:
+//         {"line": 3, "query": "path n1 n6", "status": "ok", "ms": 0.05,
+//          "result_bytes": 464, "peak_heap_bytes": 2144, "output": "...",
+//          "error": ""}
+//   tsv   header line, then line, status, ms, result_bytes,
+//         peak_heap_bytes, query, output and error separated by tabs; tab,
+//         newline and backslash are escaped as \t, \n and \\.
+//
+// result_bytes is the footprint of the result (see footprint.h) and
+// peak_heap_bytes the highest heap the query's thread allocated above
+// what it held at the start (0 when heap tracking is compiled out);
+// allocations made for the query by the workers of a parallel loop are
+// not included.
+//
+// Example:
+//       query::batch runner(graph, query::batch::JSON_LINES);
+//       runner.run(queryFile, cout);
+
+#ifndef GRAPH_QUERY_H
+#define GRAPH_QUERY_H
+
+#include "graph.h"
+#include "scc.h"
+#include "cc.h"
+#include "dfs.h"
+#include "topoSort.h"
+#include "mst.h"
+#include "shortestPath.h"
+#include "properties.h"
+#include "parallel.h"
+#include "stats.h"
+#include "resultWriter.h"
+#include "footprint.h"
+#include <chrono>
+#include <thread>
+#include <sstream>
+#include <algorithm>
+
+using namespace std;
+
+namespace query {
+
+	enum status { OK, FAILED, UNKNOWN };
+
+	// dijkstra from src with the edge weights replaced by the column weights,
+	// on D distances; prints the path to dst, or to all nodes without dst.
+	template <class D>
+	void weighted_path(basicGraph::bGraph* graph, const basicGraph::bNode* src, const basicGraph::bNode* dst,
+		const properties::column* weights, output::writer& out, footprint::report* usage)
+	{
+		short_paths::basicDijkstra<D> paths(src, graph, weights);
+		paths.build();
+		if (usage)
+			paths.memory(*usage);
+		STATS_PHASE(PRINT);
+		if (dst)
+			paths.print(dst, out);
+		else
+			paths.print(out);
+	}
+
+	// true for the commands run() answers.
+	inline bool supported(string command)
+	{
+		transform(command.begin(), command.end(), command.begin(), ::tolower);
+		return command == "scc" || command == "cc" || command == "search" ||
+			command == "sort" || command == "mst" || command == "path";
+	}
+
+	// runs one read-only command; UNKNOWN if tokens[0] is not supported.
+	// usage, if given, receives the footprint of the result; props are the
+	// node and edge properties of graph, if any.
+	inline status run(basicGraph::bGraph* graph, const vector<string>& tokens, ostream& sink, ostream& err,
+		output::format fmt = output::TEXT, footprint::report* usage = nullptr,
+		const properties::store* props = nullptr)
+	{
+		if (tokens.empty())
+			return UNKNOWN;
+		string choice = tokens[0];
+		transform(choice.begin(), choice.end(), choice.begin(), ::tolower);
+		STATS_PHASE(BUILD);
+		output::writer out(sink, fmt);
+
+		if (choice == "scc")
+		{
+			if (!graph->directed()) {
+				err << "Error: Strongly connected can not be determined for undirected graph.\n";
+				return FAILED;
+			}
+			SCC::tarjan sccBuilder(graph);
+			sccBuilder.build();
+			if (usage)
+				sccBuilder.memory(*usage);
+			STATS_PHASE(PRINT);
+			if (tokens.size() < 2)
+			{
+				sccBuilder.print(out);
+				return OK;
+			}
+			const basicGraph::bNode* node = graph->findNode(tokens[1]);
+			if (!node) {
+				err << "Error: node " << tokens[1] << "not found in the graph.\n";
+				return FAILED;
+			}
+			out.header("component,node");
+			sccBuilder.print_component(sccBuilder.component(node), out);
+			return OK;
+		}
+		else if (choice == "cc")
+		{
+			CC::afforest ccBuilder(graph);
+			ccBuilder.build();
+			if (usage)
+				ccBuilder.memory(*usage);
+			STATS_PHASE(PRINT);
+			if (tokens.size() < 2)
+			{
+				ccBuilder.print(out);
+				return OK;
+			}
+			const basicGraph::bNode* node = graph->findNode(tokens[1]);
+			if (!node) {
+				err << "Error: node " << tokens[1] << "not found in the graph.\n";
+				return FAILED;
+			}
+			out.header("component,node");
+			ccBuilder.print_component(ccBuilder.component(node), out);
+			return OK;
+		}
+		else if (choice == "search")
+		{
+			if (tokens.size() < 2) {
+				err << "Error: supply search node and try again.\n";
+				return FAILED;
+			}
+			const basicGraph::bNode* src = graph->findNode(tokens[1]);
+			if (!src) {
+				err << "Error: node " << tokens[1] << "not found in the graph.\n";
+				return FAILED;
+			}
+			DFS traverse(graph);
+			traverse.search(src, out, err);
+			return OK;
+		}
+		else if (choice == "sort")
+		{
+			if (!graph->directed()) {
+				err << "Error: topological sort works only on directed graphs.\n";
+				return FAILED;
+			}
+			kahnSort levels(graph);
+			bool sorted = levels.build();
+			if (usage)
+				levels.memory(*usage);
+			STATS_PHASE(PRINT);
+			levels.print(out, err);
+			return sorted ? OK : FAILED;
+		}
+		else if (choice == "mst")
+		{
+			string algo = tokens.size() < 2 ? "kruskal" : tokens[1];
+			if (!graph->weighted()) {
+				err << "Error: minimum spanning tree needs a weight on every edge.\n";
+				return FAILED;
+			}
+			if (algo == "kruskal")
+			{
+				MST::kruskal mst(graph);
+				mst.build(err);
+				if (usage)
+					mst.memory(*usage);
+				STATS_PHASE(PRINT);
+				mst.print(false, out);
+			}
+			else if (algo == "prim")
+			{
+				MST::prim mst(graph);
+				mst.build(err);
+				if (usage)
+					mst.memory(*usage);
+				STATS_PHASE(PRINT);
+				mst.print(false, out);
+			}
+			else {
+				err << "Error: invalid option " << algo << ". Options are\n";
+				err << "        prim.\n";
+				err << "        kruskal.\n";
+				return FAILED;
+			}
+			return OK;
+		}
+		else if (choice == "path")
+		{
+			// path <start_node> [<end_node>] [weight <edge_column>]
+			const properties::column* weights = nullptr;
+			size_t nArgs = tokens.size();
+			if (nArgs >= 4 && tokens[nArgs - 2] == "weight")
+			{
+				const string& name = tokens[nArgs - 1];
+				weights = props ? props->edges().find(name) : nullptr;
+				if (!weights) {
+					err << "Error: edge property " << name << " not found.\n";
+					return FAILED;
+				}
+				if (!weights->numeric() || weights->minimum() < 0) {
+					err << "Error: edge property " << name << " is not a non-negative int or real.\n";
+					return FAILED;
+				}
+				nArgs -= 2;
+			}
+			if (nArgs < 2) {
+				err << "Error: supply search node and try again.\n";
+				return FAILED;
+			}
+			string node1 = tokens[1];
+			string node2 = nArgs > 2 ? tokens[2] : "";
+			const basicGraph::bNode* src = graph->findNode(node1);
+			if (!src)
+			{
+				err << "Error: node " << node1 << "not found in the graph.\n";
+				return FAILED;
+			}
+			const basicGraph::bNode* dst = node2.length() ? graph->findNode(node2) : nullptr;
+			if (node2.size() && !dst)
+			{
+				err << "Error: node " << node2 << "not found in the graph.\n";
+				err << "       will use single source path algorithm.\n";
+			}
+
+			if (weights)
+			{
+				// a real column keeps its fractions: distances are doubles.
+				if (weights->kind() == properties::REAL)
+					weighted_path<double>(graph, src, dst, weights, out, usage);
+				else
+					weighted_path<size_t>(graph, src, dst, weights, out, usage);
+			}
+			else if (dst == nullptr)
+			{
+				// path to all nodes from source
+				short_paths::dijkstra single_source_path(src, graph);
+				single_source_path.build();
+				if (usage)
+					single_source_path.memory(*usage);
+				STATS_PHASE(PRINT);
+				single_source_path.print(out);
+			}
+			else
+			{
+				// a_star search for source and destination.
+				short_paths::aStar src_dst_path(src, graph);
+				src_dst_path.build(dst);
+				if (usage)
+					src_dst_path.memory(*usage);
+				STATS_PHASE(PRINT);
+				src_dst_path.print(dst, out);
+			}
+			return OK;
+		}
+		return UNKNOWN;
+	}
+
+	class batch {
+	public:
+		enum format { JSON_LINES, TSV };
+	private:
+		struct result {
+			size_t line_;
+			string query_;
+			status status_;
+			double ms_;
+			size_t resultBytes_; // footprint of the result.
+			int64_t peakBytes_;  // peak heap of the query's thread above its start.
+			string output_;
+			string error_;
+		};
+
+		basicGraph::bGraph*       graph_;
+		const properties::store*  props_;
+		format                    format_;
+		size_t                    window_;   // queries in flight.
+		size_t                    nQueries_;
+		size_t                    nFailed_;
+
+		static void escape_json(const string& s, string& text)
+		{
+			static const char hex[] = "0123456789abcdef";
+			for (size_t i = 0; i < s.size(); i++)
+			{
+				unsigned char c = static_cast<unsigned char>(s[i]);
+				switch (c)
+				{
+				case '"':  text += "\\\""; break;
+				case '\\': text += "\\\\"; break;
+				case '\n': text += "\\n";  break;
+				case '\t': text += "\\t";  break;
+				case '\r': text += "\\r";  break;
+				default:
+					if (c < 0x20) {
+						text += "\\u00";
+						text += hex[c >> 4];
+						text += hex[c & 15];
+					}
+					else
+						text += static_cast<char>(c);
+				}
+			}
+		}
+		static void escape_tsv(const string& s, string& text)
+		{
+			for (size_t i = 0; i < s.size(); i++)
+			{
+				switch (s[i])
+				{
+				case '\\': text += "\\\\"; break;
+				case '\n': text += "\\n";  break;
+				case '\t': text += "\\t";  break;
+				case '\r': text += "\\r";  break;
+				default:   text += s[i];
+				}
+			}
+		}
+
+		void format_result(const result& r, string& text) const
+		{
+			ostringstream numbers;
+			const char* state = r.status_ == OK ? "ok" : "error";
+			if (format_ == TSV)
+			{
+				numbers << r.line_ << '\t' << state << '\t' << r.ms_ << '\t' << r.resultBytes_ << '\t' << r.peakBytes_ << '\t';
+				text += numbers.str();
+				escape_tsv(r.query_, text);
+				text += '\t';
+				escape_tsv(r.output_, text);
+				text += '\t';
+				escape_tsv(r.error_, text);
+				text += '\n';
+				return;
+			}
+			numbers << "{\"line\": " << r.line_ << ", \"query\": \"";
+			text += numbers.str();
+			escape_json(r.query_, text);
+			numbers.str("");
+			numbers << "\", \"status\": \"" << state << "\", \"ms\": " << r.ms_ << ", \"result_bytes\": " << r.resultBytes_
+				<< ", \"peak_heap_bytes\": " << r.peakBytes_ << ", \"output\": \"";
+			text += numbers.str();
+			escape_json(r.output_, text);
+			text += "\", \"error\": \"";
+			escape_json(r.error_, text);
+			text += "\"}\n";
+		}
+
+		void write_window(ostream& out, const vector<result>& results, size_t count, string& text) const
+		{
+			text.clear();
+			for (size_t i = 0; i < count; i++)
+				format_result(results[i], text);
+			out.write(text.data(), text.size());
+		}
+
+		void answer(result& r) const
+		{
+			vector<string> tokens;
+			istringstream stokens(r.query_);
+			string token;
+			while (stokens >> token)
+				tokens.push_back(token);
+
+			ostringstream out, err;
+			footprint::report usage;
+			footprint::reset_thread_peak();
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			r.status_ = query::run(graph_, tokens, out, err, output::TEXT, &usage, props_);
+			r.ms_ = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+			r.resultBytes_ = usage.total();
+			r.peakBytes_   = footprint::thread_peak_growth();
+			STATS_END_PHASE();
+			if (r.status_ == UNKNOWN)
+				err << "Error: option " << tokens[0] << " not supported in batch mode.\n";
+			r.output_ = out.str();
+			r.error_  = err.str();
+		}
+	public:
+		batch(basicGraph::bGraph* graph, format fmt = JSON_LINES, size_t window = 0,
+			const properties::store* props = nullptr) :
+			graph_(graph), props_(props), format_(fmt), window_(window ? window : max<size_t>(64, 16 * parallel::nThreads())),
+			nQueries_(0), nFailed_(0)
+		{}
+
+		// answers every query of queries; returns false if out went bad.
+		bool run(istream& queries, ostream& out)
+		{
+			nQueries_ = nFailed_ = 0;
+			if (format_ == TSV)
+				out << "line\tstatus\tms\tresult_bytes\tpeak_heap_bytes\tquery\toutput\terror\n";
+
+			vector<result> results[2];
+			string         text;
+			thread         writer;
+			size_t         lineNo = 0;
+			string         line;
+			for (size_t b = 0; queries; b ^= 1)
+			{
+				results[b].clear();
+				while (results[b].size() < window_ && getline(queries, line))
+				{
+					lineNo++;
+					if (!line.empty() && line[line.size() - 1] == '\r')
+						line.erase(line.size() - 1);
+					size_t first = line.find_first_not_of(" \t");
+					if (first == string::npos || line[first] == '#')
+						continue;
+					result r;
+					r.line_   = lineNo;
+					r.query_  = line.substr(first);
+					r.status_ = UNKNOWN;
+					r.ms_     = 0;
+					r.resultBytes_ = 0;
+					r.peakBytes_   = 0;
+					results[b].push_back(r);
+				}
+				size_t count = results[b].size();
+				if (count == 0)
+					break;
+
+				parallel::dynamic_for(0, count, [&](size_t i, size_t) { answer(results[b][i]); }, 1);
+				nQueries_ += count;
+				for (size_t i = 0; i < count; i++)
+					nFailed_ += results[b][i].status_ != OK;
+
+				if (writer.joinable())
+					writer.join();
+				writer = thread([this, &out, &results, &text, b, count]() {
+					write_window(out, results[b], count, text);
+				});
+			}
+			if (writer.joinable())
+				writer.join();
+			out.flush();
+			return static_cast<bool>(out);
+		}
+
+		size_t nQueries() const { return nQueries_; }
+		size_t nFailed()  const { return nFailed_;  }
+	};
+}
+
+#endif
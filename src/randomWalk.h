@@ -0,0 +1,299 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Random Walks (DeepWalk, node2vec):
+//      Walks of fixed length are started from every node, a number of
+// times each, and written one walk per line as node names. Graph
+// embedding tools read these lines as sentences.
+//
+// First order walk: the next node is a random out neighbor, uniformly or
+// in proportion to edge weight. Weighted choice uses one alias table per
+// node (Vose), so a step is one random number and one comparison:
+//   i = random arc of u; next = random < prob[i] ? target[i] : alias[i]
+//
+// Second order walk (node2vec): coming from t to v, the weight of the
+// step to x is scaled by
+//   1/p if x == t,   1 if x is a neighbor of t,   1/q otherwise.
+// Rejection sampling: draw x from the first order distribution, accept
+// it with probability scale(x) / max scale, else draw again. Neighbor
+// lists are sorted, so "x is a neighbor of t" is a binary search. No
+// per edge tables are stored.
+//
+// Walks are generated in parallel, in batches; while one batch is being
+// written to the file, the next one is generated. Every walk has its own
+// random generator seeded from the walk number, so the output does not
+// depend on the number of threads.
+//
+// Reference: Grover, Leskovec, "node2vec: Scalable Feature Learning for
+//            Networks", KDD 2016.
+//            Yang et al., "KnightKing: A Fast Distributed Graph Random Walk
+//            Engine", SOSP 2019.
+//            Vose, "A Linear Algorithm for Generating Random Numbers with
+//            a Given Distribution", 1991.
+
+#ifndef GRAPH_RANDOMWALK_H
+#define GRAPH_RANDOMWALK_H
+
+#include "graph.h"
+#include "csr.h"
+#include "parallel.h"
+#include "stats.h"
+#include <fstream>
+#include <thread>
+#include <algorithm>
+
+using namespace std;
+
+namespace walks {
+
+	// xorshift64*, seeded through splitmix64.
+	class fastRng {
+	private:
+		uint64_t state_;
+	public:
+		fastRng(uint64_t seed)
+		{
+			uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			state_ = (z ^ (z >> 31)) | 1;
+		}
+		uint64_t next()
+		{
+			state_ ^= state_ >> 12;
+			state_ ^= state_ << 25;
+			state_ ^= state_ >> 27;
+			return state_ * 2685821657736338717ULL;
+		}
+		// uniform in [0, n).
+		uint32_t below(uint32_t n) { return static_cast<uint32_t>(((next() >> 32) * n) >> 32); }
+		// uniform in [0, 1).
+		float unit() { return static_cast<float>(next() >> 40) * (1.0f / 16777216.0f); }
+	};
+
+	struct walkOptions {
+		size_t   length_;       // nodes per walk, start included.
+		size_t   walksPerNode_;
+		double   p_, q_;        // node2vec return and in-out parameters.
+		bool     weighted_;     // weight proportional steps, if the graph has weights.
+		uint64_t seed_;
+		size_t   batch_;        // walks per batch.
+		walkOptions() : length_(80), walksPerNode_(10), p_(1), q_(1), weighted_(true),
+			seed_(20160813), batch_(1 << 16)
+		{}
+	};
+
+	class randomWalk {
+	private:
+		const basicGraph::bGraph* graph_;
+		walkOptions               options_;
+		bool                      weighted_;
+		vector<size_t>            offsets_;  // out neighbors sorted by id.
+		vector<uint32_t>          targets_;
+		vector<float>             prob_;     // alias tables, parallel to targets_.
+		vector<uint32_t>          alias_;    // arc offset within the node.
+		string                    names_;    // node names back to back, for output.
+		vector<size_t>            nameOffsets_;
+		size_t                    steps_;
+
+		void build_tables()
+		{
+			size_t n = graph_->nNodes();
+			basicGraph::csrGraph out(graph_, false, weighted_);
+			offsets_.assign(n + 1, 0);
+			for (size_t u = 0; u < n; u++)
+				offsets_[u + 1] = offsets_[u] + out.degree(u);
+			targets_.resize(out.nArcs());
+			if (weighted_) {
+				prob_.resize(out.nArcs());
+				alias_.resize(out.nArcs());
+			}
+
+			vector<vector<pair<uint32_t, double>>> scratch(parallel::nThreads());
+			vector<vector<uint32_t>>               small(parallel::nThreads()), large(parallel::nThreads());
+			parallel::dynamic_for(0, n, [&](size_t u, size_t worker) {
+				size_t first = offsets_[u], degree = offsets_[u + 1] - first;
+				vector<pair<uint32_t, double>>& arcs = scratch[worker];
+				arcs.clear();
+				for (size_t i = 0; i < degree; i++)
+					arcs.push_back(make_pair(out.begin(u)[i], weighted_ ? static_cast<double>(out.weight(first + i)) : 1.0));
+				sort(arcs.begin(), arcs.end());
+				double total = 0;
+				for (size_t i = 0; i < degree; i++)
+				{
+					targets_[first + i] = arcs[i].first;
+					total += arcs[i].second;
+				}
+				if (!weighted_ || degree == 0)
+					return;
+
+				// Vose: pair every under full slot with an over full one.
+				vector<uint32_t>& lo = small[worker];
+				vector<uint32_t>& hi = large[worker];
+				lo.clear();
+				hi.clear();
+				for (size_t i = 0; i < degree; i++)
+				{
+					arcs[i].second = total > 0 ? arcs[i].second * degree / total : 1.0;
+					(arcs[i].second < 1.0 ? lo : hi).push_back(static_cast<uint32_t>(i));
+				}
+				while (!lo.empty() && !hi.empty())
+				{
+					uint32_t s = lo.back(), l = hi.back();
+					lo.pop_back();
+					prob_[first + s]  = static_cast<float>(arcs[s].second);
+					alias_[first + s] = l;
+					arcs[l].second   -= 1.0 - arcs[s].second;
+					if (arcs[l].second < 1.0) {
+						hi.pop_back();
+						lo.push_back(l);
+					}
+				}
+				for (size_t i = 0; i < lo.size(); i++)
+					prob_[first + lo[i]] = 1.0f;
+				for (size_t i = 0; i < hi.size(); i++)
+					prob_[first + hi[i]] = 1.0f;
+			}, 256);
+		}
+
+		uint32_t step(uint32_t u, fastRng& rng) const
+		{
+			size_t   first = offsets_[u];
+			uint32_t i     = rng.below(static_cast<uint32_t>(offsets_[u + 1] - first));
+			if (weighted_ && rng.unit() >= prob_[first + i])
+				i = alias_[first + i];
+			return targets_[first + i];
+		}
+
+		bool adjacent(uint32_t u, uint32_t v) const
+		{
+			return binary_search(targets_.begin() + offsets_[u], targets_.begin() + offsets_[u + 1], v);
+		}
+
+		// one walk from start into out, returns its length.
+		size_t walk(uint32_t start, uint64_t number, uint32_t* out) const
+		{
+			fastRng rng(options_.seed_ ^ (number * 0xD1B54A32D192ED03ULL));
+			const float back = static_cast<float>(1.0 / options_.p_);
+			const float away = static_cast<float>(1.0 / options_.q_);
+			const float most = max(1.0f, max(back, away));
+			const float least = min(1.0f, min(back, away));
+			const bool  firstOrder = back == 1.0f && away == 1.0f;
+
+			out[0] = start;
+			size_t len = 1;
+			while (len < options_.length_ && offsets_[out[len - 1] + 1] > offsets_[out[len - 1]])
+			{
+				uint32_t cur = out[len - 1];
+				uint32_t next = step(cur, rng);
+				if (!firstOrder && len > 1)
+				{
+					uint32_t prev = out[len - 2];
+					while (true)
+					{
+						float y = rng.unit() * most;
+						if (y < least)
+							break;
+						float scale = next == prev ? back : (adjacent(prev, next) ? 1.0f : away);
+						if (y < scale)
+							break;
+						next = step(cur, rng);
+					}
+				}
+				out[len++] = next;
+			}
+			return len;
+		}
+
+		void write_batch(ofstream& file, const vector<uint32_t>& nodes, const vector<size_t>& lengths,
+			size_t count, string& text) const
+		{
+			text.clear();
+			for (size_t w = 0; w < count; w++)
+			{
+				const uint32_t* path = &nodes[w * options_.length_];
+				for (size_t i = 0; i < lengths[w]; i++)
+				{
+					if (i)
+						text += ' ';
+					text.append(names_, nameOffsets_[path[i]], nameOffsets_[path[i] + 1] - nameOffsets_[path[i]]);
+				}
+				text += '\n';
+			}
+			file.write(text.data(), text.size());
+		}
+	public:
+		randomWalk(const basicGraph::bGraph* graph, const walkOptions& options = walkOptions()) :
+			graph_(graph), options_(options), weighted_(false), steps_(0)
+		{
+			if (options_.weighted_)
+			{
+				set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter;
+				for (eiter = graph_->edgeBegin(); eiter != graph_->edgeEnd() && !weighted_; eiter++)
+					weighted_ = (*eiter)->hasWeight();
+			}
+			if (options_.length_ == 0)
+				options_.length_ = 1;
+			if (options_.batch_ == 0)
+				options_.batch_ = 1;
+			build_tables();
+		}
+
+		// writes all walks to filename; returns false if it can not be written.
+		bool write(string filename)
+		{
+			ofstream file(filename.c_str(), ios::binary);
+			if (!file) {
+				cerr << "Error: could not open file " << filename << ".\n";
+				return false;
+			}
+
+			size_t n = graph_->nNodes(), total = n * options_.walksPerNode_;
+			names_.clear();
+			nameOffsets_.assign(1, 0);
+			for (size_t u = 0; u < n; u++)
+			{
+				names_ += graph_->node(u)->name();
+				nameOffsets_.push_back(names_.size());
+			}
+			vector<uint32_t> nodes[2];
+			vector<size_t>   lengths[2];
+			string           text;
+			thread           writer;
+			steps_ = 0;
+			for (size_t begin = 0, b = 0; begin < total; begin += options_.batch_, b ^= 1)
+			{
+				size_t count = min(options_.batch_, total - begin);
+				nodes[b].resize(count * options_.length_);
+				lengths[b].resize(count);
+				parallel::dynamic_for(0, count, [&](size_t w, size_t) {
+					uint64_t number = begin + w;
+					lengths[b][w] = walk(static_cast<uint32_t>(number % n), number, &nodes[b][w * options_.length_]);
+				}, 256);
+				size_t batchSteps = 0;
+				for (size_t w = 0; w < count; w++)
+					batchSteps += lengths[b][w] - 1;
+				steps_ += batchSteps;
+				STATS_ADD(NODES_VISITED, count + batchSteps);
+				STATS_ADD(EDGES_SCANNED, batchSteps);
+
+				if (writer.joinable())
+					writer.join();
+				writer = thread([this, &file, &nodes, &lengths, &text, b, count]() {
+					write_batch(file, nodes[b], lengths[b], count, text);
+				});
+			}
+			if (writer.joinable())
+				writer.join();
+			return static_cast<bool>(file);
+		}
+
+		size_t steps()    const { return steps_; }
+		bool   weighted() const { return weighted_; }
+	};
+}
+
+#endif
@@ -0,0 +1,357 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Reachability Index (GRAIL):
+//      Answers "can node A reach node B" without a fresh graph search.
+//
+//   1. Nodes of one strongly connected component reach each other, so
+//      the graph is condensed to a DAG of components (Tarjan). Component
+//      ids are in topological order, an edge always goes from a smaller
+//      to a larger id. For undirected graphs components are the
+//      connected components and the DAG has no edges.
+//   2. k randomized post-order DFS traversals of the DAG give every
+//      component k intervals [low, post]: post is its post-order rank and
+//      low the smallest rank in its DFS subtree or below any child.
+//      If B is reachable from A, every interval of B lies inside the
+//      matching interval of A.
+//   3. Query(A, B):
+//         same component              -> reachable.
+//         comp(A) > comp(B)           -> not reachable (topological order).
+//         an interval not contained   -> not reachable.
+//         otherwise DFS from comp(A), pruned by the same two tests.
+//
+// Most negative queries end at step 3 in O(k). Index takes 2k+1 words
+// per component plus the DAG, and can be saved to and loaded from a file.
+//
+// Reference: Yildirim, Chaoji, Zaki, "GRAIL: Scalable Reachability Index
+//            for Large Graphs", VLDB 2010.
+
+#ifndef GRAPH_REACH_H
+#define GRAPH_REACH_H
+
+#include "scc.h"
+#include "cc.h"
+#include "marks.h"
+#include "stats.h"
+#include <random>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+namespace reachability {
+
+	class grail {
+	private:
+		static const char* magic() { return "BGAREACH1"; }
+
+		size_t           nNodes_;
+		size_t           nTraversals_;
+		vector<uint32_t> compId_;     // component of node, indexed by node id.
+		vector<size_t>   dagOffsets_; // condensation DAG in CSR form.
+		vector<uint32_t> dagTargets_;
+		vector<uint32_t> low_;        // low_[c * nTraversals_ + i]
+		vector<uint32_t> post_;       // post_[c * nTraversals_ + i]
+
+		size_t nComponents() const { return dagOffsets_.empty() ? 0 : dagOffsets_.size() - 1; }
+
+		// condense directed edges between components, without duplicates.
+		void build_dag(const basicGraph::bGraph* graph, size_t nComps)
+		{
+			vector<vector<uint32_t>> children(nComps);
+			set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter;
+			if (graph->directed())
+				for (eiter = graph->edgeBegin(); eiter != graph->edgeEnd(); eiter++)
+				{
+					uint32_t c1 = compId_[(*eiter)->n1()->id()];
+					uint32_t c2 = compId_[(*eiter)->n2()->id()];
+					if (c1 != c2)
+						children[c1].push_back(c2);
+				}
+
+			dagOffsets_.assign(1, 0);
+			dagTargets_.clear();
+			for (size_t c = 0; c < nComps; c++)
+			{
+				sort(children[c].begin(), children[c].end());
+				children[c].erase(unique(children[c].begin(), children[c].end()), children[c].end());
+				dagTargets_.insert(dagTargets_.end(), children[c].begin(), children[c].end());
+				dagOffsets_.push_back(dagTargets_.size());
+				vector<uint32_t>().swap(children[c]);
+			}
+		}
+
+		// one randomized post-order traversal, iterative for deep DAGs.
+		void label(size_t traversal, mt19937& rng)
+		{
+			size_t nComps = nComponents();
+			vector<uint32_t> roots;
+			vector<bool>     hasParent(nComps, false);
+			for (size_t i = 0; i < dagTargets_.size(); i++)
+				hasParent[dagTargets_[i]] = true;
+			for (size_t c = 0; c < nComps; c++)
+				if (!hasParent[c])
+					roots.push_back(static_cast<uint32_t>(c));
+			shuffle(roots.begin(), roots.end(), rng);
+
+			struct frame {
+				uint32_t comp_;
+				size_t   start_, next_; // children visited from a random start, wrapping around.
+			};
+			traversal::pooledMarks marks(nComps);
+			vector<frame>    stack;
+			uint32_t         rank = 0;
+			for (size_t r = 0; r < roots.size(); r++)
+			{
+				marks->set(roots[r], basicGraph::VISITING);
+				size_t degree = dagOffsets_[roots[r] + 1] - dagOffsets_[roots[r]];
+				frame root = { roots[r], degree ? rng() % degree : 0, 0 };
+				stack.push_back(root);
+				while (!stack.empty())
+				{
+					frame& top = stack.back();
+					size_t first = dagOffsets_[top.comp_], degree = dagOffsets_[top.comp_ + 1] - first;
+					size_t at = top.comp_ * nTraversals_ + traversal;
+					if (top.next_ == degree)
+					{
+						post_[at] = ++rank;
+						low_[at]  = min(low_[at], post_[at]);
+						uint32_t done = top.comp_;
+						stack.pop_back();
+						if (!stack.empty())
+						{
+							size_t parent = stack.back().comp_ * nTraversals_ + traversal;
+							low_[parent] = min(low_[parent], low_[done * nTraversals_ + traversal]);
+						}
+						continue;
+					}
+
+					uint32_t child = dagTargets_[first + (top.start_ + top.next_++) % degree];
+					if (marks->get(child) == basicGraph::NOT_VISITED)
+					{
+						marks->set(child, basicGraph::VISITING);
+						size_t childDegree = dagOffsets_[child + 1] - dagOffsets_[child];
+						frame next = { child, childDegree ? rng() % childDegree : 0, 0 };
+						stack.push_back(next); // invalidates top.
+					}
+					else
+						low_[at] = min(low_[at], low_[child * nTraversals_ + traversal]);
+				}
+			}
+			STATS_ADD(NODES_VISITED, nComps);
+			STATS_ADD(EDGES_SCANNED, dagTargets_.size());
+		}
+
+		// every interval of 'to' is inside the matching interval of 'from'.
+		bool contains(uint32_t from, uint32_t to) const
+		{
+			const uint32_t* lf = &low_[from * nTraversals_];
+			const uint32_t* pf = &post_[from * nTraversals_];
+			const uint32_t* lt = &low_[to * nTraversals_];
+			const uint32_t* pt = &post_[to * nTraversals_];
+			for (size_t i = 0; i < nTraversals_; i++)
+				if (lt[i] < lf[i] || pt[i] > pf[i])
+					return false;
+			return true;
+		}
+
+		// dfs on DAG, only into components that may still reach 'to'.
+		bool search(uint32_t from, uint32_t to) const
+		{
+			traversal::pooledMarks marks(nComponents());
+			vector<uint32_t> stack(1, from);
+			marks->set(from, basicGraph::VISITED);
+			while (!stack.empty())
+			{
+				uint32_t comp = stack.back();
+				stack.pop_back();
+				STATS_INC(NODES_VISITED);
+				for (size_t i = dagOffsets_[comp]; i < dagOffsets_[comp + 1]; i++)
+				{
+					STATS_INC(EDGES_SCANNED);
+					uint32_t child = dagTargets_[i];
+					if (child == to)
+						return true;
+					if (child > to || marks->get(child) != basicGraph::NOT_VISITED || !contains(child, to))
+						continue;
+					marks->set(child, basicGraph::VISITED);
+					stack.push_back(child);
+				}
+			}
+			return false;
+		}
+
+		template <class T>
+		static void write_vector(ofstream& out, const vector<T>& v)
+		{
+			uint64_t n = v.size();
+			out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+			out.write(reinterpret_cast<const char*>(v.data()), n * sizeof(T));
+		}
+		// false if the length is more than the bytes left in the file.
+		template <class T>
+		static bool read_vector(ifstream& in, vector<T>& v, uint64_t& left)
+		{
+			uint64_t n = 0;
+			if (left < sizeof(n) || !in.read(reinterpret_cast<char*>(&n), sizeof(n)))
+				return false;
+			left -= sizeof(n);
+			if (n > left / sizeof(T))
+				return false;
+			left -= n * sizeof(T);
+			v.resize(static_cast<size_t>(n));
+			return static_cast<bool>(in.read(reinterpret_cast<char*>(v.data()), n * sizeof(T)));
+		}
+
+		// loaded parts fit together: every id in range, dag arcs forward.
+		static bool consistent(uint64_t nNodes, uint64_t nTraversals, const vector<uint32_t>& compId,
+			const vector<size_t>& dagOffsets, const vector<uint32_t>& dagTargets,
+			const vector<uint32_t>& low, const vector<uint32_t>& post)
+		{
+			if (nTraversals == 0 || compId.size() != nNodes || dagOffsets.empty() || dagOffsets[0] != 0 ||
+				dagOffsets.back() != dagTargets.size())
+				return false;
+			size_t nComps = dagOffsets.size() - 1;
+			if (low.size() % nTraversals != 0 || low.size() / nTraversals != nComps || post.size() != low.size())
+				return false;
+			for (size_t u = 0; u < compId.size(); u++)
+				if (compId[u] >= nComps)
+					return false;
+			for (size_t c = 0; c < nComps; c++)
+			{
+				if (dagOffsets[c + 1] < dagOffsets[c] || dagOffsets[c + 1] > dagTargets.size())
+					return false;
+				for (size_t i = dagOffsets[c]; i < dagOffsets[c + 1]; i++)
+					if (dagTargets[i] >= nComps || dagTargets[i] <= c)
+						return false;
+			}
+			return true;
+		}
+	public:
+		grail(size_t traversals = 3) : nNodes_(0), nTraversals_(traversals ? traversals : 1)
+		{}
+
+		void build(const basicGraph::bGraph* graph)
+		{
+			nNodes_ = graph->nNodes();
+			compId_.assign(nNodes_, 0);
+			size_t nComps = 0;
+			if (graph->directed())
+			{
+				SCC::tarjan scc(graph);
+				scc.build();
+				nComps = scc.nComponents();
+				for (size_t u = 0; u < nNodes_; u++)
+					compId_[u] = static_cast<uint32_t>(scc.componentIds()[u]);
+			}
+			else
+			{
+				CC::afforest cc(graph);
+				cc.build();
+				nComps = cc.nComponents();
+				compId_ = cc.componentIds();
+			}
+
+			build_dag(graph, nComps);
+			low_.assign(nComps * nTraversals_, static_cast<uint32_t>(-1));
+			post_.assign(nComps * nTraversals_, 0);
+			mt19937 rng(20100913);
+			for (size_t i = 0; i < nTraversals_; i++)
+				label(i, rng);
+		}
+
+		bool reachable(const basicGraph::bNode* from, const basicGraph::bNode* to) const
+		{
+			uint32_t c1 = compId_[from->id()];
+			uint32_t c2 = compId_[to->id()];
+			if (c1 == c2)
+				return true;
+			if (c1 > c2 || !contains(c1, c2))
+				return false;
+			return search(c1, c2);
+		}
+
+		bool save(string filename) const
+		{
+			ofstream out(filename.c_str(), ios::binary);
+			if (!out) {
+				cerr << "Error: could not open file " << filename << ".\n";
+				return false;
+			}
+			uint64_t header[2] = { nNodes_, nTraversals_ };
+			out.write(magic(), strlen(magic()));
+			out.write(reinterpret_cast<const char*>(header), sizeof(header));
+			write_vector(out, compId_);
+			write_vector(out, dagOffsets_);
+			write_vector(out, dagTargets_);
+			write_vector(out, low_);
+			write_vector(out, post_);
+			return static_cast<bool>(out);
+		}
+
+		// index must have been saved for the same graph. Nothing changes
+		// unless the whole file loads and checks out.
+		bool load(string filename, const basicGraph::bGraph* graph)
+		{
+			ifstream in(filename.c_str(), ios::binary);
+			string   tag(strlen(magic()), ' ');
+			uint64_t header[2] = { 0, 0 };
+			if (!in || !in.read(&tag[0], tag.size()) || tag != magic() ||
+				!in.read(reinterpret_cast<char*>(header), sizeof(header)))
+			{
+				cerr << "Error: " << filename << " is not a reachability index.\n";
+				return false;
+			}
+			if (header[0] != graph->nNodes())
+			{
+				cerr << "Error: reachability index " << filename << " is for another graph.\n";
+				return false;
+			}
+			streamoff at = in.tellg();
+			in.seekg(0, ios::end);
+			uint64_t left = static_cast<uint64_t>(in.tellg() - at);
+			in.seekg(at);
+
+			vector<uint32_t> compId, dagTargets, low, post;
+			vector<size_t>   dagOffsets;
+			if (!read_vector(in, compId, left) || !read_vector(in, dagOffsets, left) ||
+				!read_vector(in, dagTargets, left) || !read_vector(in, low, left) || !read_vector(in, post, left))
+			{
+				cerr << "Error: reachability index " << filename << " is truncated.\n";
+				return false;
+			}
+			if (!consistent(header[0], header[1], compId, dagOffsets, dagTargets, low, post))
+			{
+				cerr << "Error: reachability index " << filename << " is corrupt.\n";
+				return false;
+			}
+			nNodes_      = header[0];
+			nTraversals_ = header[1];
+			compId_.swap(compId);
+			dagOffsets_.swap(dagOffsets);
+			dagTargets_.swap(dagTargets);
+			low_.swap(low);
+			post_.swap(post);
+			return true;
+		}
+
+		bool   empty() const { return compId_.empty(); }
+		size_t bytes() const
+		{
+			return compId_.size() * sizeof(uint32_t) + dagOffsets_.size() * sizeof(size_t) +
+				(dagTargets_.size() + low_.size() + post_.size()) * sizeof(uint32_t);
+		}
+		void print() const
+		{
+			cout << "reachability index: " << nComponents() << " components, "
+				<< dagTargets_.size() << " dag edges, " << nTraversals_ << " labels, "
+				<< bytes() << " bytes.\n";
+		}
+	};
+}
+
+#endif
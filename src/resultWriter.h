@@ -0,0 +1,259 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Result Writer:
+//      Buffered output of algorithm results (print, path, mst, scc, cc,
+// sort and search). Text, numbers and records are copied into one large
+// buffer that goes to the stream when full, so printing a result does no
+// heap allocation per record and no flush per line.
+//
+//   text    the tables of the prompt, written with operator<<.
+//   csv     a header line, then one record per line, fields separated by
+//           commas; a field with comma, quote or newline is quoted.
+//   binary  the header, then the records, as a sequence of values, all
+//           little-endian:
+//              0x01 <8 byte unsigned>         number
+//              0x02 <4 byte length> <bytes>   string
+//              0x03 <8 byte IEEE double>      real number
+//              0x00                           end of record
+//
+// A result prints its text table when text() is true, else one record per
+// row through field() and end_record().
+//
+// Example:
+//       output::writer out(cout, output::CSV);
+//       out.header("node,distance");
+//       out.field(node->name()).field(dist).end_record();
+
+#ifndef GRAPH_RESULT_WRITER_H
+#define GRAPH_RESULT_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <type_traits>
+
+using namespace std;
+
+namespace output {
+
+	enum format { TEXT, CSV, BINARY };
+
+	// format named text, csv or binary; false if the name is none of them.
+	inline bool parse_format(const string& name, format& fmt)
+	{
+		if (name == "text")        fmt = TEXT;
+		else if (name == "csv")    fmt = CSV;
+		else if (name == "binary") fmt = BINARY;
+		else return false;
+		return true;
+	}
+
+	class writer {
+	private:
+		ostream&     sink_;
+		format       format_;
+		vector<char> buf_;
+		size_t       used_;
+		bool         firstField_; // no field yet in the current record.
+
+		writer(const writer&);
+		writer& operator=(const writer&);
+
+		void put(const char* s, size_t n)
+		{
+			if (used_ + n > buf_.size())
+			{
+				flush();
+				if (n > buf_.size()) {
+					sink_.write(s, n);
+					return;
+				}
+			}
+			memcpy(&buf_[used_], s, n);
+			used_ += n;
+		}
+		void put_unsigned(uint64_t v)
+		{
+			char digits[20];
+			size_t n = 0;
+			do {
+				digits[sizeof(digits) - ++n] = static_cast<char>('0' + v % 10);
+				v /= 10;
+			} while (v);
+			put(digits + sizeof(digits) - n, n);
+		}
+		void put_signed(int64_t v)
+		{
+			if (v < 0) {
+				put("-", 1);
+				put_unsigned(uint64_t(0) - static_cast<uint64_t>(v));
+			}
+			else
+				put_unsigned(static_cast<uint64_t>(v));
+		}
+		void put_le(uint64_t v, size_t bytes)
+		{
+			char le[8];
+			for (size_t i = 0; i < bytes; i++)
+				le[i] = static_cast<char>(v >> (8 * i));
+			put(le, bytes);
+		}
+		// a real as ostream prints it by default, 6 significant digits.
+		void put_real(double v)
+		{
+			char digits[32];
+			int n = snprintf(digits, sizeof(digits), "%g", v);
+			put(digits, n > 0 ? static_cast<size_t>(n) : 0);
+		}
+		template <class T> void put_integer(T v, true_type)  { put_signed(static_cast<int64_t>(v)); }
+		template <class T> void put_integer(T v, false_type) { put_unsigned(static_cast<uint64_t>(v)); }
+
+		void separate()
+		{
+			if (format_ == CSV && !firstField_)
+				put(",", 1);
+			firstField_ = false;
+		}
+		void put_csv(const char* s, size_t n)
+		{
+			bool quote = false;
+			for (size_t i = 0; i < n && !quote; i++)
+				quote = s[i] == ',' || s[i] == '"' || s[i] == '\n' || s[i] == '\r';
+			if (!quote) {
+				put(s, n);
+				return;
+			}
+			put("\"", 1);
+			for (size_t i = 0; i < n; i++)
+			{
+				if (s[i] == '"')
+					put("\"", 1);
+				put(s + i, 1);
+			}
+			put("\"", 1);
+		}
+	public:
+		writer(ostream& sink, format fmt = TEXT, size_t capacity = size_t(1) << 16) :
+			sink_(sink), format_(fmt), buf_(capacity ? capacity : 1), used_(0), firstField_(true)
+		{}
+		~writer() { flush(); }
+
+		format fmt()  const { return format_; }
+		bool   text() const { return format_ == TEXT; }
+
+		// hands the buffered bytes to the stream (without flushing it).
+		void flush()
+		{
+			if (used_)
+				sink_.write(&buf_[0], used_);
+			used_ = 0;
+		}
+
+		// text, written as is.
+		writer& operator<<(const string& s) { put(s.data(), s.size()); return *this; }
+		writer& operator<<(const char* s)   { put(s, strlen(s)); return *this; }
+		writer& operator<<(char c)          { put(&c, 1); return *this; }
+		template <class T>
+		typename enable_if<is_integral<T>::value, writer&>::type operator<<(T v)
+		{
+			put_integer(v, integral_constant<bool, is_signed<T>::value>());
+			return *this;
+		}
+		template <class T>
+		typename enable_if<is_floating_point<T>::value, writer&>::type operator<<(T v)
+		{
+			put_real(v);
+			return *this;
+		}
+		writer& spaces(size_t n)
+		{
+			static const char blanks[] = "                                ";
+			for (; n > sizeof(blanks) - 1; n -= sizeof(blanks) - 1)
+				put(blanks, sizeof(blanks) - 1);
+			put(blanks, n);
+			return *this;
+		}
+
+		// column names separated by commas, as one record; nothing in text.
+		void header(const char* names)
+		{
+			if (format_ == CSV) {
+				*this << names << '\n';
+				return;
+			}
+			if (format_ != BINARY)
+				return;
+			for (const char* end = names; ; end++)
+			{
+				if (*end != ',' && *end != '\0')
+					continue;
+				field(names, end - names);
+				if (*end == '\0')
+					break;
+				names = end + 1;
+			}
+			end_record();
+		}
+
+		// fields of a record in csv and binary.
+		writer& field(const char* s, size_t n)
+		{
+			separate();
+			if (format_ == BINARY) {
+				put("\x02", 1);
+				put_le(n, 4);
+				put(s, n);
+			}
+			else if (format_ == CSV)
+				put_csv(s, n);
+			else
+				put(s, n);
+			return *this;
+		}
+		writer& field(const string& s) { return field(s.data(), s.size()); }
+		writer& field(const char* s)   { return field(s, strlen(s)); }
+		writer& field(uint64_t v)
+		{
+			separate();
+			if (format_ == BINARY) {
+				put("\x01", 1);
+				put_le(v, 8);
+			}
+			else
+				put_unsigned(v);
+			return *this;
+		}
+		template <class T>
+		typename enable_if<is_floating_point<T>::value, writer&>::type field(T v)
+		{
+			separate();
+			if (format_ == BINARY) {
+				double d = v;
+				uint64_t bits;
+				memcpy(&bits, &d, sizeof(bits));
+				put("\x03", 1);
+				put_le(bits, 8);
+			}
+			else
+				put_real(v);
+			return *this;
+		}
+		void end_record()
+		{
+			if (format_ == BINARY)
+				put("\x00", 1);
+			else
+				put("\n", 1);
+			firstField_ = true;
+		}
+	};
+}
+
+#endif
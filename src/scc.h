@@ -10,31 +10,95 @@
 //
 // Reference: https://en.wikipedia.org/wiki/Strongly_connected_component
 //            https://en.wikipedia.org/wiki/Kosaraju%27s_algorithm
+//            https://en.wikipedia.org/wiki/Tarjan%27s_strongly_connected_components_algorithm
 
 #ifndef GRAPH_SCC_H
 #define GRAPH_SCC_H
 
 #pragma once
 #include "transpose.h"
-#include <map>
+#include "traversal.h"
 #include <stack>
+#include <deque>
 
 using namespace std;
 
 namespace SCC {
-	map<const basicGraph::bNode*, basicGraph::NODE_MARKS> nodeMarks_;
-	void resetMarks(const basicGraph::bGraph* graph) {
-		set<const basicGraph::bNode*, basicGraph::nodeCompare>::iterator niter = graph->nodeBegin();
-		for (; niter != graph->nodeEnd(); niter++) {
-			const basicGraph::bNode* node = *niter;
-			SCC::nodeMarks_[node] = basicGraph::NOT_VISITED;
-		}
-		return;
+
+	// Numbering shared by all scc algorithms, so they print the same output:
+	// components in kahn's topological order of the condensation (sources
+	// first, ties in the order the components first appear in the node
+	// list) and members in node list order. On input group holds, by node
+	// id, any label below nNodes naming the node's component; on output it
+	// is the component number, and offsets and members list the components.
+	inline void number_components(const basicGraph::bGraph* graph, vector<size_t>& group,
+		vector<size_t>& offsets, vector<const basicGraph::bNode*>& members)
+	{
+		size_t nNodes = graph->nNodes();
+		static const size_t NONE = static_cast<size_t>(-1);
+		set<const basicGraph::bNode*, basicGraph::nodeCompare>::iterator niter;
+
+		// labels to temporary components, in order of first appearance.
+		vector<size_t> tmpOf(nNodes, NONE);
+		vector<size_t> tmpOffsets(1, 0);
+		for (niter = graph->nodeBegin(); niter != graph->nodeEnd(); niter++)
+		{
+			size_t& tmp = tmpOf[group[(*niter)->id()]];
+			if (tmp == NONE) {
+				tmp = tmpOffsets.size() - 1;
+				tmpOffsets.push_back(0);
+			}
+			tmpOffsets[tmp + 1]++;
+		}
+		size_t nComps = tmpOffsets.size() - 1;
+		for (size_t c = 0; c < nComps; c++)
+			tmpOffsets[c + 1] += tmpOffsets[c];
+		vector<size_t> tmpComp(nNodes);
+		for (size_t u = 0; u < nNodes; u++)
+			tmpComp[u] = tmpOf[group[u]];
+		vector<const basicGraph::bNode*> tmpMembers(nNodes);
+		vector<size_t>                   fill(tmpOffsets.begin(), tmpOffsets.end() - 1);
+		for (niter = graph->nodeBegin(); niter != graph->nodeEnd(); niter++)
+			tmpMembers[fill[tmpComp[(*niter)->id()]]++] = *niter;
+
+		// kahn on the condensation, parallel arcs counted once per arc.
+		vector<size_t> inDeg(nComps, 0);
+		for (niter = graph->nodeBegin(); niter != graph->nodeEnd(); niter++)
+			for (basicGraph::bNode::edgeIterator e = (*niter)->edgeBegin(); e != (*niter)->edgeEnd(); e++)
+				if (tmpComp[(*e)->n2()->id()] != tmpComp[(*niter)->id()])
+					inDeg[tmpComp[(*e)->n2()->id()]]++;
+
+		offsets.assign(1, 0);
+		members.clear();
+		members.reserve(nNodes);
+		deque<size_t> ready;
+		for (size_t c = 0; c < nComps; c++)
+			if (inDeg[c] == 0)
+				ready.push_back(c);
+		while (!ready.empty())
+		{
+			size_t c = ready.front();
+			ready.pop_front();
+			size_t comp = offsets.size() - 1;
+			for (size_t i = tmpOffsets[c]; i < tmpOffsets[c + 1]; i++)
+			{
+				const basicGraph::bNode* node = tmpMembers[i];
+				group[node->id()] = comp;
+				members.push_back(node);
+				for (basicGraph::bNode::edgeIterator e = node->edgeBegin(); e != node->edgeEnd(); e++)
+				{
+					size_t next = tmpComp[(*e)->n2()->id()];
+					if (next != c && --inDeg[next] == 0)
+						ready.push_back(next);
+				}
+			}
+			offsets.push_back(members.size());
+		}
 	}
 
 	// Algorithm:
 	//   1. For each vertex u of the graph, mark u as unvisited.Let stack_ be empty.
-	//	 2. For each vertex u of the graph do Visit(u), where Visit(u) is the recursive subroutine :
+	//	 2. For each vertex u of the graph do Visit(u), where Visit(u) is the dfs subroutine :
 	//      If u is unvisited then :
 	//         1. Mark u as visited.
 	//	       2. For each out - neighbour v of u, do Visit(v).
@@ -50,55 +114,29 @@ namespace SCC {
 		const basicGraph::bGraph*                   graph_;
 		vector < vector<const basicGraph::bNode*> > listSCC_;
 		stack<const basicGraph::bNode*>             stack_;
+		traversal::dfsEngine                        engine_;
 
 		// fill up the stack in the reverse order or finishing time.
-		void first_dfs_pass(const basicGraph::bNode* src)
-		{
-			if (SCC::nodeMarks_[src] == basicGraph::VISITED)
-				return;
-			if (SCC::nodeMarks_[src] == basicGraph::VISITING) // detected cycle.
-				return;
-			SCC::nodeMarks_[src] = basicGraph::VISITING;
-
-			set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator niter = src->edgeBegin();
-			for (; niter != src->edgeEnd(); niter++) {
-				const basicGraph::bNode* nextNode = (*niter)->otherNode(src);
-				if (SCC::nodeMarks_[nextNode] == basicGraph::NOT_VISITED)
-					first_dfs_pass(nextNode);
-			}
-
-			SCC::nodeMarks_[src] = basicGraph::VISITED;
-			stack_.push(src);
-		}
-
-
-		bool second_dfs_pass(const basicGraph::bNode* src, vector<const basicGraph::bNode*>& sccGroup)
-		{
-			if (SCC::nodeMarks_[src] == basicGraph::VISITED)
-				return false;
-			if (SCC::nodeMarks_[src] == basicGraph::VISITING) // detected cycle.
-				return false;
-			SCC::nodeMarks_[src] = basicGraph::VISITING;
-
-			set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator niter = src->edgeBegin();
-			for (; niter != src->edgeEnd(); niter++) {
-				const basicGraph::bNode* nextNode = (*niter)->otherNode(src);
-				if (SCC::nodeMarks_[nextNode] == basicGraph::NOT_VISITED)
-					second_dfs_pass(nextNode, sccGroup);
-			}
-
-			SCC::nodeMarks_[src] = basicGraph::VISITED;
-			sccGroup.push_back(src);
+		struct stackVisitor : public traversal::dfsVisitor {
+			stack<const basicGraph::bNode*>& stack_;
+			stackVisitor(stack<const basicGraph::bNode*>& st) : stack_(st) {}
+			void finish(const basicGraph::bNode* node, size_t) { stack_.push(node); }
+		};
 
-			return true; // found SCC
-		}
+		// collect all nodes reachable from the root in transposed graph.
+		struct groupVisitor : public traversal::dfsVisitor {
+			vector<const basicGraph::bNode*>& sccGroup_;
+			groupVisitor(vector<const basicGraph::bNode*>& group) : sccGroup_(group) {}
+			void finish(const basicGraph::bNode* node, size_t) { sccGroup_.push_back(node); }
+		};
 
 		void build_dfs_stack()
 		{
+			stackVisitor visitor(stack_);
 			set<const basicGraph::bNode*, basicGraph::nodeCompare>::iterator niter = graph_->nodeBegin();
 			for (; niter != graph_->nodeEnd(); niter++)
 			{
-				first_dfs_pass(*niter);
+				engine_.visit(*niter, visitor);
 			}
 			return;
 		}
@@ -108,15 +146,44 @@ namespace SCC {
 			size_t scc_index = 0;
 			while (!stack_.empty())
 			{
-				if ( second_dfs_pass(stack_.top(), listSCC_[scc_index]) )
+				groupVisitor visitor(listSCC_[scc_index]);
+				if ( engine_.visit(stack_.top(), visitor) )
 					scc_index++;
 				stack_.pop();
 			}
 			return;
 		}
+		// lists in the numbering of number_components.
+		void renumber()
+		{
+			vector<size_t> group(graph_->nNodes());
+			for (size_t i = 0; i < listSCC_.size(); i++)
+				for (size_t j = 0; j < listSCC_[i].size(); j++)
+					group[listSCC_[i][j]->id()] = i;
+			vector<size_t>                   offsets;
+			vector<const basicGraph::bNode*> members;
+			number_components(graph_, group, offsets, members);
+			for (size_t i = 0; i < listSCC_.size(); i++)
+			{
+				listSCC_[i].clear();
+				if (i + 1 < offsets.size())
+					listSCC_[i].assign(members.begin() + offsets[i], members.begin() + offsets[i + 1]);
+			}
+		}
 	public:
-		kosaraju(const basicGraph::bGraph* graph) : graph_(graph), listSCC_(graph->nNodes())
+		kosaraju(const basicGraph::bGraph* graph) : graph_(graph), listSCC_(graph->nNodes()), engine_(graph)
 		{}
+		// bytes of the component lists, see footprint.h.
+		void memory(footprint::report& usage) const
+		{
+			size_t members = 0, bytes = footprint::vector_bytes(listSCC_);
+			for (size_t i = 0; i < listSCC_.size(); i++)
+			{
+				members += listSCC_[i].size();
+				bytes += footprint::vector_bytes(listSCC_[i]);
+			}
+			usage.add("scc_lists", members, bytes);
+		}
 		void build()
 		{
 			if (!graph_->directed())
@@ -125,33 +192,217 @@ namespace SCC {
 				return;
 			}
 
-			resetMarks(graph_);
+			engine_.reset();
 			build_dfs_stack();
 
 			transpose reverse(true);
 			reverse.build(graph_);
 
-			resetMarks(graph_);
+			engine_.reset();
 			build_scc_list();
 
 			// fix directed graph before leaving.
 			reverse.build(graph_);
+
+			renumber();
 			return;
 		}
 		void print()
 		{
+			output::writer out(cout);
+			print(out);
+		}
+		void print(output::writer& out)
+		{
+			out.header("component,node");
 			for (size_t i = 0; i < listSCC_.size(); i++)
 			{
 				if (listSCC_[i].size() == 0)
 					continue;
 
-				cout << "SCC Group " << i << " : ";
+				if (!out.text()) {
+					for (size_t j = 0; j < listSCC_[i].size(); j++)
+						out.field(i).field(listSCC_[i][j]->name()).end_record();
+					continue;
+				}
+				out << "SCC Group " << i << " : ";
 				for (size_t j = 0; j < listSCC_[i].size(); j++)
 				{
-					cout << listSCC_[i][j]->name() << " ";
+					out << listSCC_[i][j]->name() << ' ';
 				}
-				cout << "\n";
+				out << '\n';
+			}
+			return;
+		}
+	};
+
+	// Strongly connected components in compact form: a component id per
+	// node (by node id) and members grouped by component with offsets.
+	class components {
+	protected:
+		vector<size_t>                   compId_;  // component id, indexed by node id.
+		vector<size_t>                   offsets_; // component c is members_[offsets_[c], offsets_[c+1]).
+		vector<const basicGraph::bNode*> members_; // nodes grouped by component.
+
+		void clear(size_t nNodes)
+		{
+			compId_.assign(nNodes, size_t(NO_COMPONENT)); // a copy, so the constant needs no definition.
+			offsets_.assign(1, 0);
+			members_.clear();
+			members_.reserve(nNodes);
+		}
+	public:
+		static const size_t NO_COMPONENT = static_cast<size_t>(-1);
+
+		components() : offsets_(1, 0)
+		{}
+		size_t nComponents() const { return offsets_.size() - 1; }
+		// bytes of the component ids and lists, see footprint.h.
+		void memory(footprint::report& usage) const
+		{
+			usage.add("component_ids", compId_.size(),  footprint::vector_bytes(compId_));
+			usage.add("offsets",       offsets_.size(), footprint::vector_bytes(offsets_));
+			usage.add("members",       members_.size(), footprint::vector_bytes(members_));
+		}
+		size_t component(const basicGraph::bNode* node) const
+		{
+			return node->id() < compId_.size() ? compId_[node->id()] : NO_COMPONENT;
+		}
+		const vector<size_t>&                   componentIds() const { return compId_;  }
+		const vector<size_t>&                   offsets()      const { return offsets_; }
+		const vector<const basicGraph::bNode*>& members()      const { return members_; }
+
+		void print_component(size_t comp, ostream& out = cout) const
+		{
+			output::writer writer(out);
+			writer.header("component,node");
+			print_component(comp, writer);
+		}
+		// in csv and binary a record (component, node) per member.
+		void print_component(size_t comp, output::writer& out) const
+		{
+			if (comp >= nComponents())
+				return;
+			if (!out.text()) {
+				for (size_t i = offsets_[comp]; i < offsets_[comp + 1]; i++)
+					out.field(comp).field(members_[i]->name()).end_record();
+				return;
+			}
+			out << "SCC Group " << comp << " : ";
+			for (size_t i = offsets_[comp]; i < offsets_[comp + 1]; i++)
+				out << members_[i]->name() << ' ';
+			out << '\n';
+		}
+		void print(ostream& out = cout) const
+		{
+			output::writer writer(out);
+			print(writer);
+		}
+		void print(output::writer& out) const
+		{
+			out.header("component,node");
+			for (size_t comp = 0; comp < nComponents(); comp++)
+				print_component(comp, out);
+			return;
+		}
+	};
+	// ##################
+	// Tarjan's algorithm
+	// ##################
+	// Single dfs pass. Every node gets a dfs index and a low link, i.e. the
+	// smallest index reachable from its dfs subtree through at most one
+	// back/cross edge to a node still on the stack. A node whose low link
+	// equals its own index is the root of an SCC, and the SCC is everything
+	// above it on the stack.
+	//
+	//   tarjan(G):
+	//      index := 0, S := empty
+	//      for each v in V, if v.index is undefined, strongconnect(v)
+	//   strongconnect(v):
+	//      v.index := v.low := index++, push v on S
+	//      for each (v, w) in E
+	//         if w.index is undefined : strongconnect(w), v.low := min(v.low, w.low)
+	//         else if w is on S       : v.low := min(v.low, w.index)
+	//      if v.low = v.index : pop S up to v, and output them as one SCC.
+	//
+	// Graph is not modified and all state is local to the object, so many
+	// queries may run concurrently on one graph.
+
+	class tarjan : public components {
+	private:
+		const basicGraph::bGraph*        graph_;
+
+		struct lowLinkVisitor : public traversal::dfsVisitor {
+			vector<size_t>&                  compId_;
+			vector<size_t>&                  offsets_;
+			vector<const basicGraph::bNode*>& members_;
+			vector<size_t>                   index_;
+			vector<size_t>                   low_;
+			vector<const basicGraph::bNode*> stack_;
+			size_t                           counter_;
+
+			lowLinkVisitor(size_t nNodes, vector<size_t>& compId, vector<size_t>& offsets,
+				vector<const basicGraph::bNode*>& members) :
+				compId_(compId), offsets_(offsets), members_(members),
+				index_(nNodes), low_(nNodes), counter_(0)
+			{}
+			void discover(const basicGraph::bNode* node, size_t)
+			{
+				index_[node->id()] = low_[node->id()] = counter_++;
+				stack_.push_back(node);
+			}
+			void backEdge(const basicGraph::bNode* from, const basicGraph::bNode* to)
+			{
+				low_[from->id()] = min(low_[from->id()], index_[to->id()]);
+			}
+			void crossEdge(const basicGraph::bNode* from, const basicGraph::bNode* to)
+			{
+				if (compId_[to->id()] == NO_COMPONENT) // still on the stack.
+					low_[from->id()] = min(low_[from->id()], index_[to->id()]);
+			}
+			void finishEdge(const basicGraph::bNode* from, const basicGraph::bNode* to)
+			{
+				low_[from->id()] = min(low_[from->id()], low_[to->id()]);
+			}
+			void finish(const basicGraph::bNode* node, size_t)
+			{
+				if (low_[node->id()] != index_[node->id()])
+					return;
+
+				size_t comp = offsets_.size() - 1;
+				const basicGraph::bNode* member = nullptr;
+				do {
+					member = stack_.back();
+					stack_.pop_back();
+					compId_[member->id()] = comp;
+					members_.push_back(member);
+				} while (member != node);
+				offsets_.push_back(members_.size());
+			}
+		};
+
+	public:
+		tarjan(const basicGraph::bGraph* graph) : components(), graph_(graph)
+		{}
+		void build()
+		{
+			if (!graph_->directed())
+			{
+				cerr << "Error: Strongly connected can not be determined for undirected graph.\n";
+				return;
 			}
+
+			clear(graph_->nNodes());
+
+			traversal::dfsEngine engine(graph_);
+			lowLinkVisitor visitor(graph_->nNodes(), compId_, offsets_, members_);
+			set<const basicGraph::bNode*, basicGraph::nodeCompare>::iterator niter = graph_->nodeBegin();
+			for (; niter != graph_->nodeEnd(); niter++)
+				engine.visit(*niter, visitor);
+
+			// tarjan emits sink components first, renumber so that component 0
+			// is a source.
+			number_components(graph_, compId_, offsets_, members_);
 			return;
 		}
 	};
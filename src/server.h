@@ -0,0 +1,441 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Query Server:
+//      Keeps a graph resident and answers the read-only queries of
+// query.h (scc, cc, search, sort, mst, path) over a Unix domain socket.
+// One thread polls the listening socket and every open connection, and
+// hands each request that arrives to a pool of worker threads. A worker
+// answers that one request and gives the connection back to the poller,
+// so an idle client holds no worker and any number of clients share the
+// pool.
+//
+// Protocol: every message is a frame, a 4 byte big-endian length and
+// that many bytes.
+//   request   the query text, as typed at the prompt.
+//   response  1 status byte ('0' ok, '1' error), 4 byte big-endian length
+//             of the output, the output, then the error text.
+// Besides the queries the server knows
+//   info               file, size and generation of the graph served.
+//   reload [<file>]    loads a new snapshot of the graph (default: the
+//                      file served) and swaps it in.
+//   shutdown           stops accepting, answers the requests already
+//                      received and closes every connection.
+//
+// Hot swap: the graph is held in a shared_ptr snapshot. A request takes
+// its own reference for its whole run, so a reload swaps the pointer
+// without waiting; the old graph is freed when its last query finishes.
+//
+// Example:
+//       bgaMain.exe graph.txt --serve /tmp/bga.sock
+//       bgaMain.exe --connect /tmp/bga.sock path n1 n6
+
+#ifndef GRAPH_SERVER_H
+#define GRAPH_SERVER_H
+
+#include "graph.h"
+#include "query.h"
+#include "parallel.h"
+#include "stats.h"
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+using namespace std;
+
+namespace service {
+
+#ifndef _WIN32
+	// largest request accepted; responses are not limited.
+	static size_t maxRequest() { return size_t(1) << 20; }
+
+	inline bool read_full(int fd, char* buf, size_t n)
+	{
+		while (n)
+		{
+			ssize_t got = ::read(fd, buf, n);
+			if (got < 0 && errno == EINTR)
+				continue;
+			if (got <= 0)
+				return false;
+			buf += got;
+			n   -= got;
+		}
+		return true;
+	}
+	inline bool write_full(int fd, const char* buf, size_t n)
+	{
+		while (n)
+		{
+			ssize_t put = ::write(fd, buf, n);
+			if (put < 0 && errno == EINTR)
+				continue;
+			if (put <= 0)
+				return false;
+			buf += put;
+			n   -= put;
+		}
+		return true;
+	}
+	inline void put_u32(string& s, uint32_t v)
+	{
+		s += static_cast<char>(v >> 24);
+		s += static_cast<char>(v >> 16);
+		s += static_cast<char>(v >> 8);
+		s += static_cast<char>(v);
+	}
+	inline uint32_t get_u32(const char* p)
+	{
+		const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+		return (uint32_t(u[0]) << 24) | (uint32_t(u[1]) << 16) | (uint32_t(u[2]) << 8) | u[3];
+	}
+
+	// frames are a 4 byte big-endian length and the payload.
+	inline bool write_frame(int fd, const string& payload)
+	{
+		string header;
+		put_u32(header, static_cast<uint32_t>(payload.size()));
+		return write_full(fd, header.data(), 4) && write_full(fd, payload.data(), payload.size());
+	}
+	inline bool read_frame(int fd, string& payload, size_t limit)
+	{
+		char header[4];
+		if (!read_full(fd, header, 4))
+			return false;
+		size_t n = get_u32(header);
+		if (n > limit)
+			return false;
+		payload.resize(n);
+		return n == 0 || read_full(fd, &payload[0], n);
+	}
+
+	inline bool socket_address(string path, sockaddr_un& addr)
+	{
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+			cerr << "Error: socket path " << path << " is empty or too long.\n";
+			return false;
+		}
+		strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+		return true;
+	}
+
+	class server {
+	private:
+		struct snapshot {
+			unique_ptr<basicGraph::bGraph> graph_;
+			string                         file_;
+			size_t                         generation_;
+			snapshot(basicGraph::bGraph* graph, string file, size_t generation) :
+				graph_(graph), file_(file), generation_(generation)
+			{}
+		};
+
+		shared_ptr<snapshot>    current_;   // read and swapped with atomic_load/atomic_store.
+		mutex                   reloadLock_;
+		mutex                   lock_;      // guards pending_ and served_.
+		condition_variable      ready_;
+		deque<int>              pending_;   // connections with a request to read.
+		vector<int>             served_;    // connections answered, back to the poller.
+		int                     wake_[2];   // pipe; a byte wakes the poller.
+		atomic<bool>            stopping_;
+		atomic<size_t>          nRequests_;
+
+		// a client that stops halfway through a frame, or does not read its
+		// response, gives up the worker after this long.
+		static int ioTimeoutSeconds() { return 10; }
+
+		void reload(string file, ostream& out, ostream& err)
+		{
+			lock_guard<mutex> guard(reloadLock_); // one load at a time.
+			shared_ptr<snapshot> old = atomic_load(&current_);
+			if (file.empty())
+				file = old->file_;
+			basicGraph::bGraph* graph = basicGraph::bGraph::readBasicGraph(file);
+			if (!graph) {
+				err << "Error: graph could not be built from " << file << ".\n";
+				return;
+			}
+			shared_ptr<snapshot> next = make_shared<snapshot>(graph, file, old->generation_ + 1);
+			atomic_store(&current_, next);
+			out << "loaded graph with " << graph->nNodes() << " nodes and " << graph->nEdges()
+				<< " edges, generation " << next->generation_ << ".\n";
+		}
+
+		// answers one request; returns the response payload.
+		string answer(const string& request)
+		{
+			vector<string> tokens;
+			istringstream stokens(request);
+			string token;
+			while (stokens >> token)
+				tokens.push_back(token);
+
+			ostringstream out, err;
+			query::status status = query::FAILED;
+			if (tokens.empty())
+				err << "Error: empty request.\n";
+			else if (tokens[0] == "info")
+			{
+				shared_ptr<snapshot> snap = atomic_load(&current_);
+				out << "graph " << snap->file_ << " with " << snap->graph_->nNodes() << " nodes and "
+					<< snap->graph_->nEdges() << " edges, generation " << snap->generation_ << ", "
+					<< nRequests_.load() << " requests served.\n";
+				status = query::OK;
+			}
+			else if (tokens[0] == "reload")
+			{
+				reload(tokens.size() > 1 ? tokens[1] : "", out, err);
+				status = err.str().empty() ? query::OK : query::FAILED;
+			}
+			else if (tokens[0] == "shutdown")
+			{
+				stopping_.store(true);
+				out << "shutting down.\n";
+				status = query::OK;
+			}
+			else
+			{
+				shared_ptr<snapshot> snap = atomic_load(&current_); // pins the graph for this query.
+				status = query::run(snap->graph_.get(), tokens, out, err);
+				STATS_END_PHASE();
+				if (status == query::UNKNOWN)
+					err << "Error: option " << tokens[0] << " not supported by the server.\n";
+			}
+			nRequests_++;
+
+			string output = out.str(), response;
+			response += status == query::OK ? '0' : '1';
+			put_u32(response, static_cast<uint32_t>(output.size()));
+			response += output;
+			response += err.str();
+			return response;
+		}
+
+		// reads and answers one request of fd, then hands fd back to the
+		// poller, or closes it if the client is gone.
+		void serve_request(int fd)
+		{
+			string request;
+			if (!read_frame(fd, request, maxRequest()) || !write_frame(fd, answer(request))) {
+				::close(fd);
+				return;
+			}
+			{
+				lock_guard<mutex> guard(lock_);
+				served_.push_back(fd);
+			}
+			char byte = 0;
+			while (::write(wake_[1], &byte, 1) < 0 && errno == EINTR)
+				;
+		}
+
+		// once stopping, answers what is pending and returns.
+		void work()
+		{
+			while (true)
+			{
+				int fd = -1;
+				{
+					unique_lock<mutex> guard(lock_);
+					while (pending_.empty() && !stopping_.load())
+						ready_.wait(guard);
+					if (pending_.empty())
+						return;
+					fd = pending_.front();
+					pending_.pop_front();
+				}
+				serve_request(fd);
+			}
+		}
+
+		static void set_timeouts(int fd)
+		{
+			timeval tv = { ioTimeoutSeconds(), 0 };
+			setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+			setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+		}
+
+		// accepts connections and queues those with a request until shutdown;
+		// returns the connections still idle then.
+		vector<int> poll_requests(int listenFd)
+		{
+			vector<int>    idle;  // open connections, no request in progress.
+			vector<pollfd> fds;
+			while (!stopping_.load())
+			{
+				{
+					lock_guard<mutex> guard(lock_);
+					idle.insert(idle.end(), served_.begin(), served_.end());
+					served_.clear();
+				}
+				fds.clear();
+				pollfd listening = { listenFd, POLLIN, 0 }, waking = { wake_[0], POLLIN, 0 };
+				fds.push_back(listening);
+				fds.push_back(waking);
+				for (size_t i = 0; i < idle.size(); i++)
+				{
+					pollfd connection = { idle[i], POLLIN, 0 };
+					fds.push_back(connection);
+				}
+				// with a timeout, so a shutdown request is noticed.
+				if (::poll(fds.data(), fds.size(), 200) <= 0)
+					continue;
+
+				if (fds[1].revents) {
+					char bytes[256];
+					while (::read(wake_[0], bytes, sizeof(bytes)) > 0)
+						;
+				}
+				vector<int> ready, waiting;
+				for (size_t i = 2; i < fds.size(); i++)
+					(fds[i].revents ? ready : waiting).push_back(fds[i].fd);
+				idle.swap(waiting);
+				if (fds[0].revents & POLLIN) {
+					int fd = ::accept(listenFd, nullptr, nullptr);
+					if (fd >= 0) {
+						set_timeouts(fd);
+						idle.push_back(fd);
+					}
+				}
+				if (!ready.empty()) {
+					lock_guard<mutex> guard(lock_);
+					pending_.insert(pending_.end(), ready.begin(), ready.end());
+					ready_.notify_all();
+				}
+			}
+			return idle;
+		}
+	public:
+		// takes ownership of graph, which was read from file.
+		server(basicGraph::bGraph* graph, string file) :
+			current_(make_shared<snapshot>(graph, file, 1)), stopping_(false), nRequests_(0)
+		{
+			wake_[0] = wake_[1] = -1;
+		}
+
+		// listens on path until a shutdown request; returns false on error.
+		bool serve(string path, size_t nWorkers = 0)
+		{
+			sockaddr_un addr;
+			if (!socket_address(path, addr))
+				return false;
+			struct stat st;
+			if (lstat(path.c_str(), &st) == 0) {
+				if (!S_ISSOCK(st.st_mode)) {
+					cerr << "Error: " << path << " exists and is not a socket.\n";
+					return false;
+				}
+				::unlink(path.c_str()); // left over from an earlier server.
+			}
+
+			int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+			if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+				::listen(listenFd, 128) != 0 || ::pipe(wake_) != 0) {
+				cerr << "Error: could not listen on " << path << ": " << strerror(errno) << ".\n";
+				if (listenFd >= 0)
+					::close(listenFd);
+				return false;
+			}
+			fcntl(wake_[0], F_SETFL, O_NONBLOCK);
+			fcntl(wake_[1], F_SETFL, O_NONBLOCK);
+			signal(SIGPIPE, SIG_IGN); // a client gone mid response is a failed write, not a crash.
+
+			stopping_.store(false);
+			nWorkers = nWorkers ? nWorkers : 2 * parallel::nThreads();
+			vector<thread> workers;
+			for (size_t w = 0; w < nWorkers; w++)
+				workers.push_back(thread([this]() { work(); }));
+
+			vector<int> idle = poll_requests(listenFd);
+
+			::close(listenFd);
+			::unlink(path.c_str());
+			{
+				lock_guard<mutex> guard(lock_);
+				ready_.notify_all();
+			}
+			for (size_t w = 0; w < workers.size(); w++)
+				workers[w].join();
+			idle.insert(idle.end(), served_.begin(), served_.end());
+			served_.clear();
+			for (size_t i = 0; i < idle.size(); i++)
+				::close(idle[i]);
+			::close(wake_[0]);
+			::close(wake_[1]);
+			wake_[0] = wake_[1] = -1;
+			return true;
+		}
+
+		size_t nRequests() const { return nRequests_.load(); }
+	};
+
+	class client {
+	private:
+		int fd_;
+		client(const client&);
+		client& operator=(const client&);
+	public:
+		client() : fd_(-1) {}
+		~client()
+		{
+			if (fd_ >= 0)
+				::close(fd_);
+		}
+		bool connect(string path)
+		{
+			sockaddr_un addr;
+			if (!socket_address(path, addr))
+				return false;
+			fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+			if (fd_ < 0 || ::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+				cerr << "Error: could not connect to " << path << ": " << strerror(errno) << ".\n";
+				return false;
+			}
+			signal(SIGPIPE, SIG_IGN);
+			return true;
+		}
+		// sends one request; false if the connection failed.
+		bool request(const string& text, bool& ok, string& output, string& error)
+		{
+			string response;
+			if (!write_frame(fd_, text) || !read_frame(fd_, response, static_cast<size_t>(-1)) || response.size() < 5) {
+				cerr << "Error: connection to the server lost.\n";
+				return false;
+			}
+			size_t n = get_u32(&response[1]);
+			if (5 + n > response.size()) {
+				cerr << "Error: malformed response from the server.\n";
+				return false;
+			}
+			ok     = response[0] == '0';
+			output = response.substr(5, n);
+			error  = response.substr(5 + n);
+			return true;
+		}
+	};
+#endif
+}
+
+#endif
@@ -25,42 +25,54 @@
 #pragma once
 #include <algorithm>
 #include <queue>
+#include <map>
 #include "graph.h"
+#include "properties.h"
 #include "heap.h"
+#include "stats.h"
 
 using namespace std;
 
 namespace short_paths {
-	struct pathNode {
+	// D is the type of the distances: size_t for integer weights, double
+	// for a real weight column.
+	template <class D>
+	struct basicPathNode {
 	public:
 		const basicGraph::bNode* node_;      // to node in graph node
-		pathNode*                prev_node_; // from node in graph node
-		size_t                   dist_;      // weight of the edge from parent to this node.
-		size_t                   root_dist_; // sum of all dist_ from this node to root.
-		pathNode(const basicGraph::bNode* node, size_t wt = 0) :
-			node_(node), prev_node_(nullptr), dist_(wt), root_dist_(LONG_MAX)
+		basicPathNode*           prev_node_; // from node in graph node
+		D                        dist_;      // weight of the edge from parent to this node.
+		D                        root_dist_; // sum of all dist_ from this node to root.
+		basicPathNode(const basicGraph::bNode* node, D wt = 0) :
+			node_(node), prev_node_(nullptr), dist_(wt), root_dist_(static_cast<D>(LONG_MAX))
 		{}
-		void setParent(pathNode* other, size_t dist, size_t root_dist) {
+		void setParent(basicPathNode* other, D dist, D root_dist) {
 			other->prev_node_ = this;
 			other->dist_      = dist;
 			other->root_dist_ = root_dist;
 		}
 	};
+	typedef basicPathNode<size_t> pathNode;
+
 	struct pathNodeCompare
 	{
-		bool operator() (const pathNode* tn1, const pathNode* tn2) const
+		template <class D>
+		bool operator() (const basicPathNode<D>* tn1, const basicPathNode<D>* tn2) const
 		{
 			return basicGraph::nodeCmp.operator()(tn1->node_, tn2->node_);
 		}
 	};
 
-	class path {
+	template <class D>
+	class basicPath {
 	private:
+		typedef basicPathNode<D> pathNode;
+
 		pathNode*                       src_;  // source for the path.
 		set<pathNode*, pathNodeCompare> tree_; // path
 
 	public:
-		path(pathNode* src) : src_(src)
+		basicPath(pathNode* src) : src_(src)
 		{
 			tree_.insert(src);
 			src->root_dist_ = 0;
@@ -69,7 +81,7 @@ namespace short_paths {
 		pathNode* retrievePathNode(const basicGraph::bNode* gnode)
 		{
             pathNode tmpNode = pathNode(gnode);
-			set<pathNode*, pathNodeCompare>::iterator niter = tree_.find(&tmpNode);
+			typename set<pathNode*, pathNodeCompare>::iterator niter = tree_.find(&tmpNode);
 			return niter == tree_.end() ? nullptr : *niter;
 		}
 		pathNode* retrieveOrAddPathNode(const basicGraph::bNode* gnode)
@@ -82,22 +94,38 @@ namespace short_paths {
 			}
 			return pnode;
 		}
-		void print_all_paths()
+		void print_all_paths(output::writer& out)
 		{
-
-			cout << "nd dist_from_src edge\n";
-			cout << "== ============= ====\n";
-			set<pathNode*, pathNodeCompare>::iterator niter = tree_.begin();
+			if (out.text()) {
+				out << "nd dist_from_src edge\n";
+				out << "== ============= ====\n";
+			}
+			else
+				out.header("node,dist_from_src,prev,dist");
+			typename set<pathNode*, pathNodeCompare>::iterator niter = tree_.begin();
 			for (; niter != tree_.end(); niter++)
 			{
 				pathNode* tnode = (*niter);
-					cout << tnode->node_->name() << " " << tnode->root_dist_ 
-					<< " [" << (tnode->prev_node_ ? tnode->prev_node_->node_->name() : "none")
-					<< "  " << tnode->node_->name() << " "	<< tnode->dist_ << "]\n";
+				if (!out.text()) {
+					out.field(tnode->node_->name()).field(tnode->root_dist_);
+					if (tnode->prev_node_)
+						out.field(tnode->prev_node_->node_->name());
+					else
+						out.field("");
+					out.field(tnode->dist_).end_record();
+					continue;
+				}
+				out << tnode->node_->name() << ' ' << tnode->root_dist_ << " [";
+				if (tnode->prev_node_)
+					out << tnode->prev_node_->node_->name();
+				else
+					out << "none";
+				out << "  " << tnode->node_->name() << ' ' << tnode->dist_ << "]\n";
 			}
 		}
 
-		void print_path(const basicGraph::bNode* dst)
+		// in csv and binary a record (node, dist, dist_from_src) per node of the path.
+		void print_path(const basicGraph::bNode* dst, output::writer& out)
 		{
 			pathNode* tnode = retrievePathNode(dst);
 
@@ -106,47 +134,68 @@ namespace short_paths {
 			{
 				if (tnode == nullptr)
 				{
-					cout << "no path found.\n";
+					if (out.text())
+						out << "no path found.\n";
+					else
+						out.header("node,dist,dist_from_src");
 					return;
 				}
 				src_2_dst.push_back(tnode);
 			} 
 			src_2_dst.push_back(src_);
 
-			cout << "start";
+			if (!out.text()) {
+				out.header("node,dist,dist_from_src");
+				for (int i = src_2_dst.size() - 1; i >= 0; i--)
+					out.field(src_2_dst[i]->node_->name()).field(src_2_dst[i]->dist_)
+						.field(src_2_dst[i]->root_dist_).end_record();
+				return;
+			}
+			out << "start";
 			for (int i=src_2_dst.size()-1; i>=0; i--)
-				cout << " --(" << src_2_dst[i]->dist_ << ")--> " << src_2_dst[i]->node_->name() ;
-			cout << " ...done.\n";
-			cout << "distance covered is " << src_2_dst[0]->root_dist_ << ".\n";
+				out << " --(" << src_2_dst[i]->dist_ << ")--> " << src_2_dst[i]->node_->name() ;
+			out << " ...done.\n";
+			out << "distance covered is " << src_2_dst[0]->root_dist_ << ".\n";
 		}
-		~path()
+		// bytes of the path nodes and their set, see footprint.h.
+		void memory(footprint::report& usage) const
 		{
-			set<pathNode*, pathNodeCompare>::iterator niter = tree_.begin();
+			usage.add("path_nodes", tree_.size(), tree_.size() * footprint::heap_block(sizeof(pathNode)));
+			usage.add("path_set",   tree_.size(), tree_.size() * footprint::tree_node_bytes<pathNode*>());
+		}
+		~basicPath()
+		{
+			typename set<pathNode*, pathNodeCompare>::iterator niter = tree_.begin();
 			for (; niter != tree_.end(); niter++)
 				delete (*niter);
 			tree_.clear();
 		}
 	};
+	typedef basicPath<size_t> path;
 
-	struct pqNode {
+	template <class D>
+	struct basicPqNode {
 	public:
 		const basicGraph::bNode* node_;
-		size_t                   min_dist_;
+		D                        min_dist_;
 
-		pqNode() : node_(nullptr), min_dist_(LONG_MAX)
+		basicPqNode() : node_(nullptr), min_dist_(static_cast<D>(LONG_MAX))
 		{}
-		pqNode(const basicGraph::bNode* node, size_t dist=LONG_MAX) : node_(node), min_dist_(dist)
+		basicPqNode(const basicGraph::bNode* node, D dist = static_cast<D>(LONG_MAX)) : node_(node), min_dist_(dist)
 		{
 			assert(node);
 		}
-		bool operator==(const pqNode& other)
+		bool operator==(const basicPqNode& other)
 		{
 			return other.node_ == node_;
 		}
 	};
+	typedef basicPqNode<size_t> pqNode;
+
 	class pqNodeCompare {
 	public:
-		bool operator() (const pqNode& tn1, const pqNode& tn2) const
+		template <class D>
+		bool operator() (const basicPqNode<D>& tn1, const basicPqNode<D>& tn2) const
 		{
 			return tn1.min_dist_ < tn2.min_dist_;
 		}
@@ -175,22 +224,37 @@ namespace short_paths {
  //    return dist[], prev[]
 
 
-	class dijkstra {
+	// dijkstra runs on size_t distances; basicDijkstra<double> takes a real
+	// weight column without rounding it.
+	template <class D>
+	class basicDijkstra {
 	private:
-		const basicGraph::bGraph* graph_;
-		path                      shortest_path_;
+		typedef basicPathNode<D> pathNode;
+		typedef basicPqNode<D>   pqNode;
 
-		size_t node_min_edge(const basicGraph::bNode* node)
+		const basicGraph::bGraph*  graph_;
+		basicPath<D>               shortest_path_;
+		const properties::column*  weights_; // overrides edge weights where it has a value.
+
+		D edge_weight(const basicGraph::bEdge* edge) const
+		{
+			if (weights_ && weights_->has(edge->id()))
+				return weights_->kind() == properties::REAL ? static_cast<D>(weights_->reals()[edge->id()])
+				                                            : static_cast<D>(weights_->ints()[edge->id()]);
+			return edge->hasWeight() ? static_cast<D>(dynamic_cast<const basicGraph::bWeightedEdge*>(edge)->weight()) : 1;
+		}
+		D node_min_edge(const basicGraph::bNode* node)
 		{
-			set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter = node->edgeBegin();
-			return eiter != node->edgeEnd() ? 
-				dynamic_cast<const basicGraph::bWeightedEdge*>(*eiter)->weight() :
-				0;
+			basicGraph::bNode::edgeIterator eiter = node->edgeBegin();
+			return eiter != node->edgeEnd() ? edge_weight(*eiter) : 0;
 		}
 	public:
-		dijkstra(const basicGraph::bNode* src, const basicGraph::bGraph* graph) :
-			graph_(graph), shortest_path_(new pathNode(src))
+		// weights, if given, is a numeric edge column (see properties.h).
+		basicDijkstra(const basicGraph::bNode* src, const basicGraph::bGraph* graph,
+			const properties::column* weights = nullptr) :
+			graph_(graph), shortest_path_(new pathNode(src)), weights_(weights)
 		{}
+		void memory(footprint::report& usage) const { shortest_path_.memory(usage); }
 		void build()
 		{
 			Heap<pqNode, pqNodeCompare> PQ; // priority queue
@@ -209,17 +273,20 @@ namespace short_paths {
 			{
 				pathNode* pnode = shortest_path_.retrievePathNode(qnode.node_);
 				assert(pnode);
+				STATS_INC(NODES_SETTLED);
 
-				set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter;
+				basicGraph::bNode::edgeIterator eiter;
 				for (eiter = pnode->node_->edgeBegin(); eiter != pnode->node_->edgeEnd(); eiter++)
 				{
 					const basicGraph::bNode* other_gnode = (*eiter)->otherNode(pnode->node_);
-					size_t dist = dynamic_cast<const basicGraph::bWeightedEdge*>(*eiter)->weight();
+					D dist = edge_weight(*eiter);
 					pathNode* other_pnode = shortest_path_.retrievePathNode(other_gnode);
+					STATS_INC(EDGES_SCANNED);
 
-					size_t alt_root_dist = pnode->root_dist_ + dist;
+					D alt_root_dist = pnode->root_dist_ + dist;
 					if (alt_root_dist < other_pnode->root_dist_)
 					{
+						STATS_INC(EDGES_RELAXED);
 						pnode->setParent(other_pnode, dist, alt_root_dist);
 						pqNode qnode_next(other_gnode, node_min_edge(other_gnode));
 						if ( PQ.exists(qnode_next) == false )
@@ -229,11 +296,22 @@ namespace short_paths {
 			}
 			return;
 		}
-		void print()
+		void print(ostream& out = cout)
+		{
+			output::writer writer(out);
+			print(writer);
+		}
+		void print(output::writer& out)
 		{
-			shortest_path_.print_all_paths();
+			shortest_path_.print_all_paths(out);
+		}
+		// path from the source to dst.
+		void print(const basicGraph::bNode* dst, output::writer& out)
+		{
+			shortest_path_.print_path(dst, out);
 		}
 	};
+	typedef basicDijkstra<size_t> dijkstra;
 
 
 //function aStar (Graph, source, destination) :
@@ -260,12 +338,12 @@ namespace short_paths {
 //                src_dist[v] ← alt
 //                prev[v] ← u
 //
-//            alt_priority[v] ← src_dist[v] + dst_dist[v, destination] 
-//            if v in PQ
-//                if alt_priority[v] < priority[v] 
-//                    priority[v] ← = alt_priority[v]
-//            else
-//                add v to PQ
+//                alt_priority[v] ← src_dist[v] + dst_dist[v, destination] 
+//                if v in PQ
+//                    if alt_priority[v] < priority[v] 
+//                        priority[v] ← = alt_priority[v]
+//                else
+//                    add v to PQ
 //
 //		terminate if priority(PQ[0]) >= src_dist[destination]
 //
@@ -278,6 +356,11 @@ namespace short_paths {
 		map<const basicGraph::bNode*, size_t, basicGraph::nodeCompare> 
 			                       h_x;
 
+		// weight of edge, 1 for an edge without one as in dijkstra.
+		static size_t edge_weight(const basicGraph::bEdge* edge)
+		{
+			return edge->hasWeight() ? dynamic_cast<const basicGraph::bWeightedEdge*>(edge)->weight() : 1;
+		}
 		// this returns estimated distance of node to destination node.
 		size_t estimate_distance(const basicGraph::bNode* node, const basicGraph::bNode* dst)
 		{
@@ -306,7 +389,7 @@ namespace short_paths {
 				nodeq.pop();
 
 				// calculate min arrival wt of every node starting from src.
-				set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter;
+				basicGraph::bNode::edgeIterator eiter;
 				for (eiter = node->edgeBegin(); eiter != node->edgeEnd(); eiter++)
 				{
 					// avoid cycles
@@ -315,7 +398,7 @@ namespace short_paths {
 					visited.insert(*eiter);
 
 					const basicGraph::bNode* next_node = (*eiter)->otherNode(node);
-					size_t wt = dynamic_cast<const basicGraph::bWeightedEdge*>(*eiter)->weight();
+					size_t wt = edge_weight(*eiter);
 					size_t next_node_wt = h_x[node] + wt;
 					if (h_x.find(next_node) != h_x.end())
 					{
@@ -337,6 +420,12 @@ namespace short_paths {
 		{
 			heuristic(src);
 		}
+		void memory(footprint::report& usage) const
+		{
+			shortest_path_.memory(usage);
+			usage.add("heuristic", h_x.size(),
+				h_x.size() * footprint::tree_node_bytes<pair<const basicGraph::bNode* const, size_t> >());
+		}
 		void build(const basicGraph::bNode* dst)
 		{
 			Heap<pqNode, pqNodeCompare> PQ; // priority queue, i.e. open set
@@ -359,20 +448,26 @@ namespace short_paths {
 
 				pathNode* pnode = shortest_path_.retrievePathNode(qnode.node_);
 				assert(pnode);
+				STATS_INC(NODES_SETTLED);
 
-				set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter;
+				basicGraph::bNode::edgeIterator eiter;
 				for (eiter = pnode->node_->edgeBegin(); eiter != pnode->node_->edgeEnd(); eiter++)
 				{
 					const basicGraph::bNode* other_gnode = (*eiter)->otherNode(pnode->node_);
-					size_t dist = dynamic_cast<const basicGraph::bWeightedEdge*>(*eiter)->weight();
+					size_t dist = edge_weight(*eiter);
 					pathNode* other_pnode = shortest_path_.retrievePathNode(other_gnode);
+					STATS_INC(EDGES_SCANNED);
 
 					size_t estimate = estimate_distance(other_gnode, dst);
 					size_t alt_root_dist = pnode->root_dist_ + dist;
 					size_t src2dst_estimate = alt_root_dist + estimate;
 
-					if ( alt_root_dist < other_pnode->root_dist_ )
-						pnode->setParent(other_pnode, dist, alt_root_dist);
+					// only a node that got closer is queued again; re-queueing the
+					// others loops forever on cycles when dst is not reachable.
+					if ( alt_root_dist >= other_pnode->root_dist_ )
+						continue;
+					STATS_INC(EDGES_RELAXED);
+					pnode->setParent(other_pnode, dist, alt_root_dist);
 
 					pqNode qnode_next(other_gnode, src2dst_estimate);
 
@@ -381,6 +476,7 @@ namespace short_paths {
 					{
 						if (PQ[idx].min_dist_ > src2dst_estimate)
 						{
+							STATS_INC(HEAP_DECREASE_KEYS);
 							PQ.erase(qnode_next); // erase old element with wrong priority
 							PQ.push(qnode_next);  // add new element
 						}
@@ -398,9 +494,14 @@ namespace short_paths {
 			}
 			return;
 		}
-		void print(const basicGraph::bNode* dst)
+		void print(const basicGraph::bNode* dst, ostream& out = cout)
+		{
+			output::writer writer(out);
+			print(dst, writer);
+		}
+		void print(const basicGraph::bNode* dst, output::writer& out)
 		{
-			shortest_path_.print_path(dst);
+			shortest_path_.print_path(dst, out);
 		}
 
 	};
@@ -0,0 +1,260 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Instrumentation:
+//      Work counters of the engines (nodes settled, edges relaxed, heap
+// operations, union/find calls, dfs depth, ...) and phase timers (load,
+// build, print). Engines bump counters through the STATS_* macros; build
+// with -DBGA_NO_STATS and the macros expand to nothing.
+//
+// Every thread counts into its own block, so parallel engines do not
+// share a cache line. A block is a plain add (relaxed atomic load and
+// store, no lock prefix); readers sum all live blocks plus the totals of
+// threads that have exited. Phases are timed per thread too, so queries
+// running concurrently add up their times.
+//
+// Example:
+//       stats::reset();
+//       short_paths::dijkstra sssp(src, graph);
+//       sssp.build();
+//       uint64_t work = stats::get(stats::EDGES_RELAXED);
+
+#ifndef GRAPH_STATS_H
+#define GRAPH_STATS_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+namespace stats {
+
+	enum counter {
+		NODES_SETTLED,      // nodes whose distance (or tree edge) became final.
+		NODES_VISITED,      // nodes discovered by a traversal.
+		EDGES_SCANNED,      // out edges looked at.
+		EDGES_RELAXED,      // edges that improved a distance.
+		HEAP_PUSHES,
+		HEAP_POPS,
+		HEAP_DECREASE_KEYS,
+		UNION_CALLS,
+		FIND_CALLS,
+		FLOW_PUSHES,        // max flow pushes along a residual arc.
+		FLOW_RELABELS,      // max flow height changes.
+		NODE_MOVES,         // nodes moved to another community.
+		NODES_PEELED,       // nodes removed while peeling k-cores.
+		DFS_MAX_DEPTH,      // deepest dfs stack, a maximum and not a sum.
+		N_COUNTERS
+	};
+
+	enum phase { LOAD, BUILD, PRINT, N_PHASES };
+
+	inline const char* name(counter c)
+	{
+		static const char* names[N_COUNTERS] = {
+			"nodes_settled", "nodes_visited", "edges_scanned", "edges_relaxed", "heap_pushes",
+			"heap_pops", "heap_decrease_keys", "union_calls", "find_calls", "flow_pushes",
+			"flow_relabels", "node_moves", "nodes_peeled", "dfs_max_depth"
+		};
+		return names[c];
+	}
+	inline const char* name(phase p)
+	{
+		static const char* names[N_PHASES] = { "load", "build", "print" };
+		return names[p];
+	}
+
+	inline bool enabled()
+	{
+#ifdef BGA_NO_STATS
+		return false;
+#else
+		return true;
+#endif
+	}
+
+	struct block;
+
+	// live blocks of all threads, and what exited threads counted.
+	class registry {
+	private:
+		mutex          lock_;
+		vector<block*> live_;
+		uint64_t       retired_[N_COUNTERS];
+		uint64_t       retiredNs_[N_PHASES];
+	public:
+		registry()
+		{
+			fill(retired_, retired_ + N_COUNTERS, 0);
+			fill(retiredNs_, retiredNs_ + N_PHASES, 0);
+		}
+		inline void attach(block* b);
+		inline void detach(block* b);
+		inline uint64_t get(counter c);
+		inline uint64_t nanoseconds(phase p);
+		inline void reset(bool withLoad);
+	};
+
+	inline registry& global()
+	{
+		static registry r;
+		return r;
+	}
+
+	struct block {
+		atomic<uint64_t> values_[N_COUNTERS];
+		atomic<uint64_t> ns_[N_PHASES];
+		int              phase_;  // phase being timed by this thread, -1 if none.
+		chrono::steady_clock::time_point start_;
+		block() : phase_(-1)
+		{
+			for (size_t c = 0; c < N_COUNTERS; c++)
+				values_[c].store(0, memory_order_relaxed);
+			for (size_t p = 0; p < N_PHASES; p++)
+				ns_[p].store(0, memory_order_relaxed);
+			global().attach(this);
+		}
+		~block() { global().detach(this); }
+	};
+
+	inline void registry::attach(block* b)
+	{
+		lock_guard<mutex> guard(lock_);
+		live_.push_back(b);
+	}
+	inline void registry::detach(block* b)
+	{
+		lock_guard<mutex> guard(lock_);
+		for (size_t c = 0; c < N_COUNTERS; c++)
+		{
+			uint64_t v = b->values_[c].load(memory_order_relaxed);
+			retired_[c] = c == DFS_MAX_DEPTH ? max(retired_[c], v) : retired_[c] + v;
+		}
+		for (size_t p = 0; p < N_PHASES; p++)
+			retiredNs_[p] += b->ns_[p].load(memory_order_relaxed);
+		live_.erase(find(live_.begin(), live_.end(), b));
+	}
+	inline uint64_t registry::get(counter c)
+	{
+		lock_guard<mutex> guard(lock_);
+		uint64_t total = retired_[c];
+		for (size_t i = 0; i < live_.size(); i++)
+		{
+			uint64_t v = live_[i]->values_[c].load(memory_order_relaxed);
+			total = c == DFS_MAX_DEPTH ? max(total, v) : total + v;
+		}
+		return total;
+	}
+	inline uint64_t registry::nanoseconds(phase p)
+	{
+		lock_guard<mutex> guard(lock_);
+		uint64_t total = retiredNs_[p];
+		for (size_t i = 0; i < live_.size(); i++)
+			total += live_[i]->ns_[p].load(memory_order_relaxed);
+		return total;
+	}
+	inline void registry::reset(bool withLoad)
+	{
+		lock_guard<mutex> guard(lock_);
+		fill(retired_, retired_ + N_COUNTERS, 0);
+		for (size_t p = 0; p < N_PHASES; p++)
+			if (withLoad || p != LOAD)
+				retiredNs_[p] = 0;
+		for (size_t i = 0; i < live_.size(); i++)
+		{
+			for (size_t c = 0; c < N_COUNTERS; c++)
+				live_[i]->values_[c].store(0, memory_order_relaxed);
+			for (size_t p = 0; p < N_PHASES; p++)
+				if (withLoad || p != LOAD)
+					live_[i]->ns_[p].store(0, memory_order_relaxed);
+		}
+	}
+
+	inline block& local()
+	{
+		static thread_local block b;
+		return b;
+	}
+
+	inline void add(counter c, uint64_t n)
+	{
+		atomic<uint64_t>& v = local().values_[c];
+		v.store(v.load(memory_order_relaxed) + n, memory_order_relaxed);
+	}
+	inline void maximize(counter c, uint64_t x)
+	{
+		atomic<uint64_t>& v = local().values_[c];
+		if (x > v.load(memory_order_relaxed))
+			v.store(x, memory_order_relaxed);
+	}
+
+	// counter summed over all threads since the last reset.
+	inline uint64_t get(counter c) { return global().get(c); }
+	// milliseconds spent in phase since the last reset, summed over threads.
+	inline double elapsed(phase p) { return global().nanoseconds(p) / 1e6; }
+
+	// ends the phase of the calling thread, if any.
+	inline void leave()
+	{
+		block& b = local();
+		if (b.phase_ < 0)
+			return;
+		uint64_t ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - b.start_).count();
+		b.ns_[b.phase_].store(b.ns_[b.phase_].load(memory_order_relaxed) + ns, memory_order_relaxed);
+		b.phase_ = -1;
+	}
+	// ends the current phase of the calling thread and starts p.
+	inline void enter(phase p)
+	{
+		leave();
+		block& b = local();
+		b.phase_ = p;
+		b.start_ = chrono::steady_clock::now();
+	}
+
+	// clears counters and build/print timers; load time is kept unless asked.
+	inline void reset(bool withLoad = false) { global().reset(withLoad); }
+
+	// times a scope as one phase.
+	class scopedPhase {
+	public:
+		scopedPhase(phase p) { enter(p); }
+		~scopedPhase()       { leave(); }
+	};
+
+	inline void print()
+	{
+		cout << "counter value\n";
+		cout << "======= =====\n";
+		for (size_t c = 0; c < N_COUNTERS; c++)
+			cout << name(counter(c)) << " " << get(counter(c)) << "\n";
+		cout << "phase ms\n";
+		cout << "===== ==\n";
+		for (size_t p = 0; p < N_PHASES; p++)
+			cout << name(phase(p)) << " " << elapsed(phase(p)) << "\n";
+	}
+}
+
+#ifndef BGA_NO_STATS
+#define STATS_ADD(c, n)  stats::add(stats::c, (n))
+#define STATS_INC(c)     stats::add(stats::c, 1)
+#define STATS_MAX(c, x)  stats::maximize(stats::c, (x))
+#define STATS_PHASE(p)   stats::enter(stats::p)
+#define STATS_END_PHASE() stats::leave()
+#else
+#define STATS_ADD(c, n)  ((void)0)
+#define STATS_INC(c)     ((void)0)
+#define STATS_MAX(c, x)  ((void)0)
+#define STATS_PHASE(p)   ((void)0)
+#define STATS_END_PHASE() ((void)0)
+#endif
+
+#endif
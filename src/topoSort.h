@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Levelized Topological Sort (Kahn's algorithm):
+//      Nodes with no incoming edges form level 1. Removing a level lowers
+// the in-degree of its successors; nodes whose in-degree drops to zero
+// form the next level. Nodes of one level do not depend on each other,
+// so a level is a batch of tasks that can run in parallel.
+//
+// Each level (frontier) is processed in parallel with atomic in-degree
+// decrements. Levels are returned in a compact form: node ids of all
+// levels in one array, level l is order_[offsets_[l], offsets_[l+1]).
+//
+// If some nodes are never freed, they sit on or behind a cycle. One
+// concrete cycle is then extracted by walking in-edges backward among
+// those nodes; every one of them has such an in-edge, so the walk must
+// revisit a node.
+//
+//   L := empty, S := nodes with in-degree 0
+//   while S is not empty
+//      append S to L as one level
+//      for each u in S, for each (u, v) in E
+//         decrement in-degree of v, if it is 0 add v to next S
+//   if L holds fewer than |V| nodes, graph has a cycle.
+//
+// Reference: https://en.wikipedia.org/wiki/Topological_sorting#Kahn's_algorithm
+
+#ifndef GRAPH_TOPO_SORT_H
+#define GRAPH_TOPO_SORT_H
+
+#include "graph.h"
+#include "csr.h"
+#include "parallel.h"
+#include "stats.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+using namespace std;
+
+class kahnSort {
+private:
+	const basicGraph::bGraph*        graph_;
+	vector<uint32_t>                 order_;   // node ids, level by level.
+	vector<size_t>                   offsets_; // level l is order_[offsets_[l], offsets_[l+1]).
+	vector<const basicGraph::bNode*> cycle_;   // a cycle, if graph is not a DAG.
+
+	// walk backward among unsorted nodes until a node repeats.
+	void find_cycle(const basicGraph::csrGraph& bwd, unique_ptr<atomic<uint32_t>[]>& inDeg)
+	{
+		size_t n = graph_->nNodes();
+		uint32_t u = 0;
+		while (u < n && inDeg[u].load() == 0)
+			u++;
+		if (u == n)
+			return;
+
+		vector<size_t> step(n, 0); // 1 + position of node on the walk.
+		vector<uint32_t> walk;
+		while (step[u] == 0)
+		{
+			walk.push_back(u);
+			step[u] = walk.size();
+			const uint32_t* w = bwd.begin(u);
+			while (inDeg[*w].load() == 0) // an unsorted predecessor always exists.
+				w++;
+			u = *w;
+		}
+		// walk[step[u]-1 ..] is the cycle, backward. Report it forward.
+		cycle_.push_back(graph_->node(u));
+		for (size_t i = walk.size(); i-- > step[u]; )
+			cycle_.push_back(graph_->node(walk[i]));
+		cycle_.push_back(graph_->node(u));
+	}
+public:
+	kahnSort(const basicGraph::bGraph* graph) : graph_(graph), offsets_(1, 0)
+	{}
+	// bytes of the levels and the cycle, see footprint.h.
+	void memory(footprint::report& usage) const
+	{
+		usage.add("order",   order_.size(),   footprint::vector_bytes(order_));
+		usage.add("offsets", offsets_.size(), footprint::vector_bytes(offsets_));
+		usage.add("cycle",   cycle_.size(),   footprint::vector_bytes(cycle_));
+	}
+
+	// returns false if graph is undirected or has a cycle.
+	bool build()
+	{
+		order_.clear();
+		offsets_.assign(1, 0);
+		cycle_.clear();
+		if (!graph_->directed()) {
+			cerr << "Error: topological sort works only on directed graphs.\n";
+			return false;
+		}
+
+		size_t n = graph_->nNodes();
+		basicGraph::csrGraph fwd(graph_);
+		unique_ptr<atomic<uint32_t>[]> inDeg(new atomic<uint32_t>[n]);
+		parallel::parallel_for(0, n, [&](size_t u) { inDeg[u].store(0, memory_order_relaxed); });
+		parallel::parallel_for(0, n, [&](size_t u) {
+			for (const uint32_t* w = fwd.begin(u); w != fwd.end(u); w++)
+				inDeg[*w].fetch_add(1, memory_order_relaxed);
+		});
+
+		order_.reserve(n);
+		for (size_t u = 0; u < n; u++)
+			if (inDeg[u].load(memory_order_relaxed) == 0)
+				order_.push_back(static_cast<uint32_t>(u));
+
+		vector<vector<uint32_t>> local(parallel::nThreads());
+		while (offsets_.back() < order_.size())
+		{
+			size_t lo = offsets_.back(), hi = order_.size();
+			offsets_.push_back(hi);
+			parallel::for_chunks(lo, hi, [&](size_t first, size_t last, size_t chunk) {
+				size_t scanned = 0;
+				for (size_t i = first; i < last; i++)
+				{
+					uint32_t u = order_[i];
+					scanned += fwd.degree(u);
+					for (const uint32_t* w = fwd.begin(u); w != fwd.end(u); w++)
+						if (inDeg[*w].fetch_sub(1, memory_order_acq_rel) == 1)
+							local[chunk].push_back(*w);
+				}
+				STATS_ADD(EDGES_SCANNED, scanned);
+			}, 256);
+			for (size_t c = 0; c < local.size(); c++)
+			{
+				order_.insert(order_.end(), local[c].begin(), local[c].end());
+				local[c].clear();
+			}
+			// same order for any number of threads.
+			sort(order_.begin() + hi, order_.end());
+		}
+
+		STATS_ADD(NODES_SETTLED, order_.size());
+		if (order_.size() < n)
+		{
+			find_cycle(basicGraph::csrGraph(graph_, true), inDeg);
+			return false;
+		}
+		return true;
+	}
+
+	size_t nLevels() const { return offsets_.size() - 1; }
+	const vector<uint32_t>&                 order()   const { return order_;   }
+	const vector<size_t>&                   offsets() const { return offsets_; }
+	const vector<const basicGraph::bNode*>& cycle()   const { return cycle_;   }
+
+	void print(ostream& out = cout, ostream& err = cerr) const
+	{
+		output::writer writer(out);
+		print(writer, err);
+	}
+	// in csv and binary a record (level, node) per node.
+	void print(output::writer& out, ostream& err = cerr) const
+	{
+		if (!cycle_.empty())
+		{
+			err << "Error: cycle detected ";
+			for (size_t i = 0; i < cycle_.size(); i++)
+				err << (i ? " -> " : "") << cycle_[i]->name();
+			err << ". Topological sorting abandoned.\n";
+			return;
+		}
+		out.header("level,node");
+		for (size_t level = 0; level < nLevels(); level++)
+		{
+			if (!out.text()) {
+				for (size_t i = offsets_[level]; i < offsets_[level + 1]; i++)
+					out.field(level + 1).field(graph_->node(order_[i])->name()).end_record();
+				continue;
+			}
+			out << "level " << level + 1 << " : ";
+			for (size_t i = offsets_[level]; i < offsets_[level + 1]; i++)
+				out << graph_->node(order_[i])->name() << ' ';
+			out << '\n';
+		}
+	}
+};
+
+#endif
@@ -52,8 +52,9 @@ public:
 		for (eiter = new_graph->edgeBegin(); eiter != new_graph->edgeEnd(); eiter++)
 		{
 			const_cast<basicGraph::bEdge*>(*eiter)->swap_nodes();
-			const_cast<basicGraph::bNode*>((*eiter)->n1())->addEdge(*eiter);
+			const_cast<basicGraph::bNode*>((*eiter)->n1())->appendEdge(*eiter);
 		}
+		const_cast<basicGraph::bGraph*>(new_graph)->sortEdgeLists();
 		return new_graph;
 	}
 };
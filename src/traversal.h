@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Traversal Engine:
+//      Iterative depth first search shared by DFS tree and strongly
+// connected components. An explicit stack replaces the native call
+// stack, so depth of the graph is limited by heap and not by the thread's
+// stack size.
+//
+// Events are reported to a visitor (static dispatch, no virtual calls):
+//      discover(u, depth)   u is reached for the first time.
+//      backEdge(u, v)       v is still on the dfs stack (cycle).
+//      crossEdge(u, v)      v is already finished (forward or cross edge).
+//      finishEdge(u, v)     tree edge u->v is retreated after v finished.
+//      finish(u, depth)     all out edges of u have been explored.
+//
+// Workspace (stack and marks) is kept by the engine and reused across
+// searches. Marks come from the shared pool (marks.h) and reset in O(1).
+
+#ifndef GRAPH_TRAVERSAL_H
+#define GRAPH_TRAVERSAL_H
+
+#include "graph.h"
+#include "marks.h"
+#include "stats.h"
+#include <vector>
+
+using namespace std;
+
+namespace traversal {
+
+	// default visitor, derive and hide the events of interest.
+	struct dfsVisitor {
+		void discover(const basicGraph::bNode*, size_t)                          {}
+		void backEdge(const basicGraph::bNode*, const basicGraph::bNode*)        {}
+		void crossEdge(const basicGraph::bNode*, const basicGraph::bNode*)       {}
+		void finishEdge(const basicGraph::bNode*, const basicGraph::bNode*)      {}
+		void finish(const basicGraph::bNode*, size_t)                            {}
+	};
+
+	class dfsEngine {
+	private:
+		struct frame {
+			const basicGraph::bNode*        node_;
+			basicGraph::bNode::edgeIterator next_;
+			frame(const basicGraph::bNode* node) : node_(node), next_(node->edgeBegin()) {}
+		};
+		const basicGraph::bGraph* graph_;
+		vector<frame>             stack_;
+		pooledMarks               marks_;
+		size_t                    maxDepth_; // deepest stack seen since reset.
+	public:
+		dfsEngine(const basicGraph::bGraph* graph) :
+			graph_(graph), marks_(graph ? graph->nNodes() : 0), maxDepth_(0)
+		{
+			reset();
+		}
+
+		// forget all marks, keeping the allocated workspace.
+		void reset()
+		{
+			marks_->reset(graph_ ? graph_->nNodes() : 0);
+			maxDepth_ = 0;
+		}
+
+		basicGraph::NODE_MARKS mark(const basicGraph::bNode* node) const
+		{
+			return marks_->get(node->id());
+		}
+		size_t maxDepth() const { return maxDepth_; }
+
+		// explore every node reachable from src, which is not yet visited.
+		// returns false if src was already visited.
+		template <class VISITOR>
+		bool visit(const basicGraph::bNode* src, VISITOR& visitor)
+		{
+			if (marks_->get(src->id()) != basicGraph::NOT_VISITED)
+				return false;
+
+			marks_->set(src->id(), basicGraph::VISITING);
+			STATS_INC(NODES_VISITED);
+			visitor.discover(src, 0);
+			stack_.push_back(frame(src));
+
+			while (!stack_.empty())
+			{
+				if (stack_.size() > maxDepth_)
+					maxDepth_ = stack_.size();
+
+				frame& top = stack_.back();
+				const basicGraph::bNode* node = top.node_;
+				if (top.next_ == node->edgeEnd())
+				{
+					marks_->set(node->id(), basicGraph::VISITED);
+					visitor.finish(node, stack_.size() - 1);
+					stack_.pop_back();
+					if (!stack_.empty())
+						visitor.finishEdge(stack_.back().node_, node);
+					continue;
+				}
+
+				const basicGraph::bNode* nextNode = (*top.next_)->otherNode(node);
+				top.next_++;
+				STATS_INC(EDGES_SCANNED);
+				switch (marks_->get(nextNode->id()))
+				{
+				case basicGraph::NOT_VISITED:
+					marks_->set(nextNode->id(), basicGraph::VISITING);
+					STATS_INC(NODES_VISITED);
+					visitor.discover(nextNode, stack_.size());
+					stack_.push_back(frame(nextNode)); // invalidates top.
+					break;
+				case basicGraph::VISITING:
+					visitor.backEdge(node, nextNode);
+					break;
+				case basicGraph::VISITED:
+					visitor.crossEdge(node, nextNode);
+					break;
+				}
+			}
+			STATS_MAX(DFS_MAX_DEPTH, maxDepth_);
+			return true;
+		}
+	};
+}
+
+#endif
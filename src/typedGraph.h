@@ -0,0 +1,344 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Typed Graph:
+//      Graph<Direction, Weight> is an adjacency snapshot of a bGraph (in
+// the layout of csr.h) whose direction and weight type are fixed at
+// compile time:
+//
+//   Direction  Directed or Undirected. Undirected adds every edge to the
+//              adjacency of both end nodes, also over a directed bGraph.
+//   Weight     uint32_t, uint64_t, float, double or Unweighted. Arcs keep
+//              a weight of that type, 4 bytes for uint32_t and float, and
+//              no weight at all for Unweighted, where every arc weighs 1.
+//
+// Algorithms written against Graph<D, W> are instantiated per type, so
+// tests of direction and weight fold away and an Unweighted search does
+// not touch weights. shortestPaths runs dijkstra, or breadth first search
+// on Unweighted graphs.
+//
+// anyGraph hides the type for the prompt: build() picks the instantiation
+// from the graph direction and a weight name, auto choosing Unweighted for
+// a graph without weights, else uint32_t when all weights fit, else uint64_t.
+//
+// Example:
+//       basicGraph::Graph<basicGraph::Directed, uint32_t> g(graph);
+//       basicGraph::shortestPaths<basicGraph::Graph<basicGraph::Directed, uint32_t> > paths(g);
+//       paths.build(src->id());
+
+#ifndef GRAPH_TYPED_GRAPH_H
+#define GRAPH_TYPED_GRAPH_H
+
+#include "graph.h"
+#include "parallel.h"
+#include "footprint.h"
+#include "stats.h"
+#include <stdint.h>
+#include <limits>
+#include <queue>
+#include <memory>
+#include <functional>
+
+using namespace std;
+
+namespace basicGraph {
+
+	struct Directed   { enum { directed = true  }; };
+	struct Undirected { enum { directed = false }; };
+	struct Unweighted {};
+
+	// weights parallel to the arcs.
+	template <class W>
+	class arcWeights {
+	private:
+		vector<W> w_;
+	public:
+		typedef W value_type;
+		enum { weighted = true };
+		void resize(size_t n) { w_.resize(n); }
+		void set(size_t arc, size_t w) { w_[arc] = static_cast<W>(w); }
+		W operator[](size_t arc) const { return w_[arc]; }
+		size_t bytes() const { return footprint::vector_bytes(w_); }
+	};
+	// no storage, every arc weighs 1.
+	template <>
+	class arcWeights<Unweighted> {
+	public:
+		typedef uint32_t value_type;
+		enum { weighted = false };
+		void resize(size_t) {}
+		void set(size_t, size_t) {}
+		uint32_t operator[](size_t) const { return 1; }
+		size_t bytes() const { return 0; }
+	};
+
+	template <class Dir, class W>
+	class Graph {
+	public:
+		typedef Dir direction;
+		typedef W   weight_type;
+		typedef typename arcWeights<W>::value_type value_type;
+		enum { directed = Dir::directed, weighted = arcWeights<W>::weighted };
+	private:
+		const bGraph*    graph_;   // nodes, for their names.
+		vector<size_t>   offsets_; // nNodes()+1 entries.
+		vector<uint32_t> targets_; // neighbor node ids.
+		arcWeights<W>    weights_; // parallel to targets_.
+
+		void add(size_t from, size_t to, const bEdge* edge, vector<size_t>& fill)
+		{
+			size_t slot = fill[from]++;
+			targets_[slot] = static_cast<uint32_t>(to);
+			if (weighted)
+				weights_.set(slot, edge->hasWeight() ?
+					dynamic_cast<const bWeightedEdge*>(edge)->weight() : 1);
+		}
+	public:
+		explicit Graph(const bGraph* graph) : graph_(graph), offsets_(graph->nNodes() + 1, 0)
+		{
+			set<const bEdge*, edgeCompare>::iterator eiter;
+			for (eiter = graph->edgeBegin(); eiter != graph->edgeEnd(); eiter++)
+			{
+				offsets_[(*eiter)->n1()->id()]++;
+				if (!directed && (*eiter)->n1() != (*eiter)->n2())
+					offsets_[(*eiter)->n2()->id()]++;
+			}
+			offsets_.back() = parallel::exclusive_scan(offsets_.data(), offsets_.data(), graph->nNodes(),
+				size_t(0), [](size_t a, size_t b) { return a + b; });
+
+			targets_.resize(offsets_.back());
+			weights_.resize(offsets_.back());
+			vector<size_t> fill(offsets_.begin(), offsets_.end() - 1);
+			for (eiter = graph->edgeBegin(); eiter != graph->edgeEnd(); eiter++)
+			{
+				size_t from = (*eiter)->n1()->id(), to = (*eiter)->n2()->id();
+				add(from, to, *eiter, fill);
+				if (!directed && from != to)
+					add(to, from, *eiter, fill);
+			}
+		}
+
+		size_t nNodes() const { return offsets_.size() - 1; }
+		size_t nArcs()  const { return targets_.size(); }
+		const bNode* node(size_t u) const { return graph_->node(u); }
+
+		// arcs of u are [offset(u), offset(u+1)), to target(arc) with weight(arc).
+		size_t     offset(size_t u)   const { return offsets_[u]; }
+		uint32_t   target(size_t arc) const { return targets_[arc]; }
+		value_type weight(size_t arc) const { return weights_[arc]; }
+
+		// bytes of the arrays, see footprint.h.
+		void memory(footprint::report& usage) const
+		{
+			usage.add("offsets", offsets_.size(), footprint::vector_bytes(offsets_));
+			usage.add("targets", targets_.size(), footprint::vector_bytes(targets_));
+			usage.add("weights", weighted ? targets_.size() : 0, weights_.bytes());
+		}
+	};
+
+	// sums of integer weights are kept in 64 bits, of floating point ones
+	// in double, and hop counts in 32 bits.
+	template <class W> struct distanceOf             { typedef uint64_t type; };
+	template <>        struct distanceOf<float>      { typedef double   type; };
+	template <>        struct distanceOf<double>     { typedef double   type; };
+	template <>        struct distanceOf<Unweighted> { typedef uint32_t type; };
+
+	// Single source shortest paths on Graph<D, W>.
+	// Complexity:
+	//       O((V + E) log V) with weights, O(V + E) Unweighted.
+	template <class G>
+	class shortestPaths {
+	public:
+		typedef typename distanceOf<typename G::weight_type>::type distance_type;
+		static const uint32_t NONE = UINT32_MAX;
+	private:
+		const G&              graph_;
+		vector<distance_type> dist_; // from the source, indexed by node id.
+		vector<uint32_t>      prev_; // node before it on the path.
+
+		void search(uint32_t src, Unweighted)
+		{
+			vector<uint32_t> frontier(1, src), next;
+			while (!frontier.empty())
+			{
+				next.clear();
+				for (size_t i = 0; i < frontier.size(); i++)
+				{
+					uint32_t u = frontier[i];
+					for (size_t arc = graph_.offset(u); arc < graph_.offset(u + 1); arc++)
+					{
+						STATS_INC(EDGES_SCANNED);
+						uint32_t v = graph_.target(arc);
+						if (dist_[v] != UNREACHED()) continue;
+						STATS_INC(NODES_VISITED);
+						dist_[v] = dist_[u] + 1;
+						prev_[v] = u;
+						next.push_back(v);
+					}
+				}
+				frontier.swap(next);
+			}
+		}
+		template <class W>
+		void search(uint32_t src, W)
+		{
+			typedef pair<distance_type, uint32_t> entry;
+			priority_queue<entry, vector<entry>, greater<entry> > queue;
+			queue.push(entry(0, src));
+			STATS_INC(HEAP_PUSHES);
+			while (!queue.empty())
+			{
+				entry top = queue.top();
+				queue.pop();
+				STATS_INC(HEAP_POPS);
+				uint32_t u = top.second;
+				if (top.first != dist_[u]) continue; // stale entry.
+				STATS_INC(NODES_SETTLED);
+				for (size_t arc = graph_.offset(u); arc < graph_.offset(u + 1); arc++)
+				{
+					STATS_INC(EDGES_SCANNED);
+					uint32_t      v = graph_.target(arc);
+					distance_type d = dist_[u] + static_cast<distance_type>(graph_.weight(arc));
+					if (d >= dist_[v]) continue;
+					STATS_INC(EDGES_RELAXED);
+					STATS_INC(HEAP_PUSHES);
+					dist_[v] = d;
+					prev_[v] = u;
+					queue.push(entry(d, v));
+				}
+			}
+		}
+	public:
+		static distance_type UNREACHED() { return numeric_limits<distance_type>::max(); }
+
+		shortestPaths(const G& graph) : graph_(graph)
+		{}
+		void build(uint32_t src)
+		{
+			dist_.assign(graph_.nNodes(), UNREACHED());
+			prev_.assign(graph_.nNodes(), NONE);
+			if (src >= graph_.nNodes())
+				return;
+			dist_[src] = 0;
+			search(src, typename G::weight_type());
+		}
+		bool          reached(uint32_t u)  const { return dist_[u] != UNREACHED(); }
+		distance_type distance(uint32_t u) const { return dist_[u]; }
+		uint32_t      prev(uint32_t u)     const { return prev_[u]; }
+
+		void print(ostream& out = cout) const
+		{
+			out << "node dist prev\n";
+			out << "==== ==== ====\n";
+			for (uint32_t u = 0; u < dist_.size(); u++)
+			{
+				if (!reached(u)) continue;
+				out << graph_.node(u)->name() << " " << dist_[u] << " "
+					<< (prev_[u] == NONE ? string("-") : graph_.node(prev_[u])->name()) << "\n";
+			}
+		}
+		void print_path(uint32_t dst, ostream& out = cout) const
+		{
+			if (!reached(dst)) {
+				out << graph_.node(dst)->name() << " is not reachable.\n";
+				return;
+			}
+			vector<uint32_t> route;
+			for (uint32_t u = dst; u != NONE; u = prev_[u])
+				route.push_back(u);
+			for (size_t i = route.size(); i-- > 0; )
+				out << graph_.node(route[i])->name() << (i ? " " : "\n");
+			out << "distance covered is " << dist_[dst] << ".\n";
+		}
+	};
+
+	template <class G>
+	const uint32_t shortestPaths<G>::NONE;
+
+	// a Graph<D, W> of a type chosen at run time.
+	class anyGraph {
+	private:
+		struct concept {
+			virtual ~concept() {}
+			virtual size_t nArcs() const = 0;
+			virtual void memory(footprint::report& usage) const = 0;
+			virtual void print_paths(const bNode* src, const bNode* dst, ostream& out) const = 0;
+		};
+		template <class G>
+		struct model : public concept {
+			G graph_;
+			model(const bGraph* graph) : graph_(graph) {}
+			size_t nArcs() const { return graph_.nArcs(); }
+			void memory(footprint::report& usage) const { graph_.memory(usage); }
+			void print_paths(const bNode* src, const bNode* dst, ostream& out) const
+			{
+				shortestPaths<G> paths(graph_);
+				paths.build(static_cast<uint32_t>(src->id()));
+				STATS_PHASE(PRINT);
+				if (dst)
+					paths.print_path(static_cast<uint32_t>(dst->id()), out);
+				else
+					paths.print(out);
+			}
+		};
+
+		unique_ptr<concept> impl_;
+		string              kind_;
+
+		template <class D>
+		static concept* make(const bGraph* graph, const string& weights)
+		{
+			if (weights == "uint32")     return new model<Graph<D, uint32_t> >(graph);
+			if (weights == "uint64")     return new model<Graph<D, uint64_t> >(graph);
+			if (weights == "float")      return new model<Graph<D, float> >(graph);
+			if (weights == "double")     return new model<Graph<D, double> >(graph);
+			if (weights == "unweighted") return new model<Graph<D, Unweighted> >(graph);
+			return nullptr;
+		}
+		// narrowest weight type that holds every weight of graph.
+		static string fit_weights(const bGraph* graph)
+		{
+			bool weighted = false;
+			size_t most = 0;
+			set<const bEdge*, edgeCompare>::iterator eiter;
+			for (eiter = graph->edgeBegin(); eiter != graph->edgeEnd(); eiter++)
+			{
+				if (!(*eiter)->hasWeight()) continue;
+				weighted = true;
+				most = max(most, dynamic_cast<const bWeightedEdge*>(*eiter)->weight());
+			}
+			if (!weighted)
+				return "unweighted";
+			return most <= UINT32_MAX ? "uint32" : "uint64";
+		}
+	public:
+		// weights is auto, uint32, uint64, float, double or unweighted;
+		// returns false, and keeps the current graph, if it is none of them.
+		bool build(const bGraph* graph, string weights = "auto")
+		{
+			if (weights == "auto")
+				weights = fit_weights(graph);
+			concept* impl = graph->directed() ?
+				make<Directed>(graph, weights) : make<Undirected>(graph, weights);
+			if (!impl)
+				return false;
+			impl_.reset(impl);
+			kind_ = string(graph->directed() ? "directed " : "undirected ") + weights;
+			return true;
+		}
+		bool empty() const { return !impl_; }
+		const string& kind() const { return kind_; }
+		size_t nArcs() const { return impl_->nArcs(); }
+		void memory(footprint::report& usage) const { impl_->memory(usage); }
+		// distances from src to all nodes, or the path to dst if given.
+		void print_paths(const bNode* src, const bNode* dst, ostream& out = cout) const
+		{
+			impl_->print_paths(src, dst, out);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,1032 @@
+///////////////////////////////////////////////////////////////////
+//    Copyright (c) 2018 Rohit Sharma. All rights reserved.
+//    This program is free software; you can redistribute it and/or
+//    modify it under the terms as GNU General Public License.
+///////////////////////////////////////////////////////////////////
+//
+// Unit tests:
+//      Checks the engines on the graph files of this directory and on a
+// small generated R-MAT graph (see src/generators.h), against each other
+// where several engines answer the same question and against a brute
+// force reference otherwise.
+//
+// Every failed check prints a line; at the end a summary line gives the
+// number of checks and failures. Exit status is 1 if any check failed.
+// Warnings the engines print are muted.
+//
+// Usage:
+//       bgaTest.exe [--dir <test_dir>] [--threads <n>] [<test> ...]
+
+#include "../src/generators.h"
+#include "../src/scc.h"
+#include "../src/parallelScc.h"
+#include "../src/reach.h"
+#include "../src/cc.h"
+#include "../src/triangles.h"
+#include "../src/kcore.h"
+#include "../src/maxFlow.h"
+#include "../src/pagerank.h"
+#include "../src/louvain.h"
+#include "../src/query.h"
+#include "../src/server.h"
+#include "../src/parallel.h"
+#include "../src/transpose.h"
+#include "../src/dvector.h"
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+#include <chrono>
+
+using namespace std;
+
+static size_t nChecks   = 0;
+static size_t nFailures = 0;
+
+static bool check(bool ok, const string& what)
+{
+	nChecks++;
+	if (!ok) {
+		nFailures++;
+		fprintf(stderr, "FAIL: %s\n", what.c_str());
+	}
+	return ok;
+}
+
+// discards everything written to it.
+class nullBuffer : public streambuf {
+protected:
+	int overflow(int c) { return c; }
+	streamsize xsputn(const char*, streamsize n) { return n; }
+};
+
+// runs body with cout and cerr muted.
+template <class BODY>
+static void quiet(BODY body)
+{
+	static nullBuffer sink;
+	streambuf* out = cout.rdbuf(&sink);
+	streambuf* err = cerr.rdbuf(&sink);
+	body();
+	cout.rdbuf(out);
+	cerr.rdbuf(err);
+}
+
+// graph files of the test directory, and the generated one.
+static vector<string> graph_files(const string& dir)
+{
+	static const char* names[] = {
+		"dgraph1.txt", "dgraph2.txt", "dgraph3.txt", "dgraph4.txt", "dgraph5.txt",
+		"dgraph6.txt", "dgraph7.txt", "dgraph8.txt",
+		"ugraph1.txt", "ugraph2.txt", "ugraph3.txt", "bga_test_rmat.txt"
+	};
+	vector<string> files;
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+		files.push_back(dir + "/" + names[i]);
+	return files;
+}
+
+static basicGraph::bGraph* load(const string& file)
+{
+	basicGraph::bGraph* graph = nullptr;
+	quiet([&]() { graph = basicGraph::bGraph::readBasicGraph(file); });
+	check(graph != nullptr, "load " + file);
+	return graph;
+}
+
+// ###
+// scc: tarjan (scc), multistep (pscc) and kosaraju print the same output.
+// ###
+static void test_scc(const string& dir)
+{
+	vector<string> files = graph_files(dir);
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		basicGraph::bGraph* graph = load(files[f]);
+		if (!graph)
+			continue;
+		if (graph->directed()) {
+			ostringstream tarjanOut, multistepOut, kosarajuOut;
+			quiet([&]() {
+				SCC::tarjan tarjan(graph);
+				tarjan.build();
+				tarjan.print(tarjanOut);
+				SCC::multistep multistep(graph);
+				multistep.build();
+				multistep.print(multistepOut);
+				SCC::kosaraju kosaraju(graph);
+				kosaraju.build();
+				output::writer out(kosarajuOut);
+				kosaraju.print(out);
+			});
+			check(!tarjanOut.str().empty(), "scc prints components of " + files[f]);
+			check(multistepOut.str() == tarjanOut.str(), "pscc output equals scc output on " + files[f]);
+			check(kosarajuOut.str() == tarjanOut.str(), "kosaraju output equals scc output on " + files[f]);
+		}
+		delete graph;
+	}
+}
+
+// neighbor of node over edge: the other end in undirected graphs.
+static const basicGraph::bNode* other_end(const basicGraph::bNode* node, const basicGraph::bEdge* edge)
+{
+	return edge->n1() == node ? edge->n2() : edge->n1();
+}
+
+// nodes reachable from src by plain bfs, by node id.
+static vector<bool> bfs_reach(const basicGraph::bGraph* graph, const basicGraph::bNode* src)
+{
+	vector<bool> seen(graph->nNodes(), false);
+	vector<const basicGraph::bNode*> queue(1, src);
+	seen[src->id()] = true;
+	for (size_t head = 0; head < queue.size(); head++)
+	{
+		const basicGraph::bNode* u = queue[head];
+		for (basicGraph::bNode::edgeIterator e = u->edgeBegin(); e != u->edgeEnd(); e++)
+		{
+			const basicGraph::bNode* v = other_end(u, *e);
+			if (!seen[v->id()]) {
+				seen[v->id()] = true;
+				queue.push_back(v);
+			}
+		}
+	}
+	return seen;
+}
+
+// neighbors of every node by id, ignoring direction, without self loops
+// and repeats.
+static vector<set<uint32_t>> undirected_neighbors(const basicGraph::bGraph* graph)
+{
+	vector<set<uint32_t>> adj(graph->nNodes());
+	set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator eiter;
+	for (eiter = graph->edgeBegin(); eiter != graph->edgeEnd(); eiter++)
+	{
+		uint32_t u = static_cast<uint32_t>((*eiter)->n1()->id());
+		uint32_t v = static_cast<uint32_t>((*eiter)->n2()->id());
+		if (u != v) {
+			adj[u].insert(v);
+			adj[v].insert(u);
+		}
+	}
+	return adj;
+}
+
+// ###
+// cc: afforest finds the components a bfs ignoring direction finds,
+// numbered by their smallest node id.
+// ###
+static void test_cc(const string& dir)
+{
+	vector<string> files = graph_files(dir);
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		basicGraph::bGraph* graph = load(files[f]);
+		if (!graph)
+			continue;
+		vector<set<uint32_t>> adj = undirected_neighbors(graph);
+		const uint32_t   none = static_cast<uint32_t>(-1);
+		vector<uint32_t> comp(graph->nNodes(), none);
+		vector<size_t>   sizes;
+		for (size_t src = 0; src < comp.size(); src++)
+		{
+			if (comp[src] != none)
+				continue;
+			uint32_t id = static_cast<uint32_t>(sizes.size());
+			vector<uint32_t> queue(1, static_cast<uint32_t>(src));
+			comp[src] = id;
+			for (size_t head = 0; head < queue.size(); head++)
+				for (set<uint32_t>::iterator v = adj[queue[head]].begin(); v != adj[queue[head]].end(); v++)
+					if (comp[*v] == none) {
+						comp[*v] = id;
+						queue.push_back(*v);
+					}
+			sizes.push_back(queue.size());
+		}
+
+		CC::afforest cc(graph);
+		cc.build();
+		check(cc.nComponents() == sizes.size(), "cc count equals bfs on " + files[f]);
+		check(cc.componentIds() == comp, "cc components equal bfs on " + files[f]);
+		check(cc.sizes() == sizes, "cc sizes equal bfs on " + files[f]);
+		delete graph;
+	}
+}
+
+// ###
+// triangles: per node and total counts equal a check of every node
+// triple, with and without per node counting.
+// ###
+static void test_triangles(const string& dir)
+{
+	vector<string> files = graph_files(dir);
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		basicGraph::bGraph* graph = load(files[f]);
+		if (!graph)
+			continue;
+		vector<set<uint32_t>> adj = undirected_neighbors(graph);
+		size_t           n = adj.size();
+		vector<uint64_t> atNode(n, 0);
+		uint64_t         total = 0;
+		for (uint32_t u = 0; u < n; u++)
+			for (uint32_t v = u + 1; v < n; v++)
+			{
+				if (!adj[u].count(v))
+					continue;
+				for (uint32_t w = v + 1; w < n; w++)
+					if (adj[u].count(w) && adj[v].count(w)) {
+						atNode[u]++;
+						atNode[v]++;
+						atNode[w]++;
+						total++;
+					}
+			}
+
+		triangles::triangleCount local(graph);
+		local.build();
+		check(local.total() == total, "triangle total equals brute force on " + files[f]);
+		check(local.counts() == atNode, "triangles per node equal brute force on " + files[f]);
+		triangles::triangleCount global(graph);
+		global.build(false);
+		check(global.total() == total, "triangle total without local counts on " + files[f]);
+		delete graph;
+	}
+}
+
+// ###
+// kcore: serial and parallel peeling give the core numbers of the
+// definition: the largest k such that the node survives removing all
+// nodes of degree below k, over and over.
+// ###
+static void test_kcore(const string& dir)
+{
+	vector<string> files = graph_files(dir);
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		basicGraph::bGraph* graph = load(files[f]);
+		if (!graph)
+			continue;
+		vector<set<uint32_t>> adj = undirected_neighbors(graph);
+		size_t           n = adj.size();
+		vector<uint32_t> core(n, 0);
+		for (uint32_t k = 1; ; k++)
+		{
+			vector<bool>   alive(n, true);
+			vector<size_t> degree(n);
+			for (size_t u = 0; u < n; u++)
+				degree[u] = adj[u].size();
+			for (bool removed = true; removed; )
+			{
+				removed = false;
+				for (size_t u = 0; u < n; u++)
+					if (alive[u] && degree[u] < k) {
+						alive[u] = false;
+						removed  = true;
+						for (set<uint32_t>::iterator v = adj[u].begin(); v != adj[u].end(); v++)
+							degree[*v]--;
+					}
+			}
+			if (find(alive.begin(), alive.end(), true) == alive.end())
+				break;
+			for (size_t u = 0; u < n; u++)
+				if (alive[u])
+					core[u] = k;
+		}
+
+		cores::kcore buckets(graph), levels(graph);
+		buckets.build(false);
+		levels.build(true);
+		check(buckets.cores() == core, "kcore equals brute force on " + files[f]);
+		check(levels.cores() == core, "parallel kcore equals brute force on " + files[f]);
+		delete graph;
+	}
+}
+
+// capacity of an edge for max flow: its weight, or 1.
+static int64_t capacity(const basicGraph::bEdge* edge)
+{
+	return edge->hasWeight() ? static_cast<int64_t>(dynamic_cast<const basicGraph::bWeightedEdge*>(edge)->weight()) : 1;
+}
+
+// max flow and min cut of every node pair of graph against the smallest
+// cut over all node subsets with s and without t.
+static void check_flows(const basicGraph::bGraph* graph, const string& what)
+{
+	size_t n = graph->nNodes(), wrongFlows = 0, wrongCuts = 0;
+	vector<const basicGraph::bEdge*> edges(graph->edgeBegin(), graph->edgeEnd());
+	for (size_t s = 0; s < n; s++)
+		for (size_t t = 0; t < n; t++)
+		{
+			if (s == t)
+				continue;
+			int64_t best = -1;
+			for (uint32_t side = 0; side < (uint32_t(1) << n); side++)
+			{
+				if (!(side >> s & 1) || (side >> t & 1))
+					continue;
+				int64_t cut = 0;
+				for (size_t i = 0; i < edges.size(); i++)
+				{
+					bool in1 = side >> edges[i]->n1()->id() & 1, in2 = side >> edges[i]->n2()->id() & 1;
+					if ((in1 && !in2) || (!graph->directed() && in2 && !in1))
+						cut += capacity(edges[i]);
+				}
+				if (best < 0 || cut < best)
+					best = cut;
+			}
+
+			flow::pushRelabel maxFlow(graph, graph->node(s), graph->node(t));
+			maxFlow.build();
+			vector<bool> side = maxFlow.source_side();
+			vector<const basicGraph::bEdge*> cut = maxFlow.cut();
+			int64_t cutCapacity = 0;
+			for (size_t i = 0; i < cut.size(); i++)
+				cutCapacity += capacity(cut[i]);
+			wrongFlows += maxFlow.value() != best;
+			wrongCuts  += cutCapacity != best || !side[s] || side[t];
+		}
+	check(wrongFlows == 0, "max flow equals the brute force min cut of every pair on " + what);
+	check(wrongCuts == 0, "min cut separates and has the flow's capacity for every pair on " + what);
+}
+
+// ###
+// maxflow: flow value and cut of every node pair equal a brute force
+// minimum cut, on the small test graphs and on random weighted ones.
+// ###
+static void test_maxflow(const string& dir)
+{
+	const size_t   maxNodes = 12;
+	vector<string> files = graph_files(dir);
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		basicGraph::bGraph* graph = load(files[f]);
+		if (graph && graph->nNodes() <= maxNodes)
+			check_flows(graph, files[f]);
+		delete graph;
+	}
+
+	generators::splitmix rng(40);
+	for (size_t round = 0; round < 8; round++)
+	{
+		basicGraph::bGraph graph(round % 2 == 0);
+		for (size_t i = 0; i < 20; i++)
+			graph.addNodesAndEdge("n" + to_string(rng.below(9)), "n" + to_string(rng.below(9)), 1 + rng.below(20));
+		check_flows(&graph, "random graph " + to_string(round));
+	}
+}
+
+// ###
+// reach: grail answers as bfs does, also after a save and load; corrupt
+// index files are rejected.
+// ###
+static void test_reach(const string& dir)
+{
+	vector<string> files = graph_files(dir);
+	string index = dir + "/bga_test_reach.idx";
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		basicGraph::bGraph* graph = load(files[f]);
+		if (!graph)
+			continue;
+		reachability::grail built, loaded;
+		bool ok = false;
+		quiet([&]() {
+			built.build(graph);
+			ok = built.save(index) && loaded.load(index, graph);
+		});
+		check(ok, "reach index saves and loads for " + files[f]);
+
+		size_t wrong = 0;
+		for (size_t a = 0; a < graph->nNodes(); a++)
+		{
+			vector<bool> reference = bfs_reach(graph, graph->node(a));
+			for (size_t b = 0; b < graph->nNodes(); b++)
+				wrong += built.reachable(graph->node(a), graph->node(b)) != reference[b] ||
+					loaded.reachable(graph->node(a), graph->node(b)) != reference[b];
+		}
+		check(wrong == 0, "reach equals bfs on " + files[f]);
+		delete graph;
+	}
+
+	// a huge length, a component id out of range and a short file.
+	basicGraph::bGraph* graph = load(dir + "/dgraph2.txt");
+	if (!graph)
+		return;
+	reachability::grail index2;
+	quiet([&]() { index2.build(graph); index2.save(index); });
+	ifstream in(index.c_str(), ios::binary);
+	string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	in.close();
+	size_t lengthAt = strlen("BGAREACH1") + 2 * sizeof(uint64_t);
+	for (int corruption = 0; corruption < 3; corruption++)
+	{
+		string bad = bytes;
+		if (corruption == 0)
+			bad[lengthAt + 7] = '\x40';
+		else if (corruption == 1)
+			bad[lengthAt + 8 + 2] = '\x7f';
+		else
+			bad.resize(bad.size() - 5);
+		ofstream out(index.c_str(), ios::binary);
+		out << bad;
+		out.close();
+		reachability::grail rejected;
+		bool loaded = true;
+		quiet([&]() { loaded = rejected.load(index, graph); });
+		check(!loaded && rejected.empty(), "corrupt reach index " + to_string(corruption) + " is rejected");
+	}
+	remove(index.c_str());
+	delete graph;
+}
+
+// ###
+// pagerank: equal to a plain power iteration; stopping at the iteration
+// cap is not reported as convergence.
+// ###
+static void test_pagerank(const string& dir)
+{
+	vector<string> files = graph_files(dir);
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		basicGraph::bGraph* graph = load(files[f]);
+		if (!graph)
+			continue;
+		size_t n = graph->nNodes();
+		const double damping = 0.85;
+		ranking::pagerank<double> ranks(graph, damping, 1e-12, 1000);
+		ranks.build();
+		check(ranks.converged(), "pagerank converges on " + files[f]);
+
+		vector<double> rank(n, 1.0 / n), next(n);
+		for (size_t iteration = 0; iteration < 1000; iteration++)
+		{
+			double dangling = 0;
+			for (size_t u = 0; u < n; u++)
+				if (graph->node(u)->degree() == 0)
+					dangling += rank[u];
+			fill(next.begin(), next.end(), (1 - damping) / n + damping * dangling / n);
+			for (size_t u = 0; u < n; u++)
+			{
+				const basicGraph::bNode* node = graph->node(u);
+				for (basicGraph::bNode::edgeIterator e = node->edgeBegin(); e != node->edgeEnd(); e++)
+					next[other_end(node, *e)->id()] += damping * rank[u] / node->degree();
+			}
+			rank.swap(next);
+		}
+		double error = 0;
+		for (size_t u = 0; u < n; u++)
+			error = max(error, fabs(rank[u] - ranks.ranks()[u]));
+		check(error < 1e-9, "pagerank equals power iteration on " + files[f]);
+
+		ranking::pagerank<double> capped(graph, damping, 1e-12, 1);
+		capped.build();
+		check(capped.iterations() == 1 && (!capped.converged() || capped.change() < 1e-12),
+			"pagerank stopped by the cap is not converged on " + files[f]);
+		delete graph;
+	}
+}
+
+// modularity of the partition comm, as louvain defines it.
+static double modularity(const basicGraph::bGraph* graph, const vector<uint32_t>& comm)
+{
+	double m2 = 0, in = 0;
+	map<uint32_t, double> tot;
+	for (set<const basicGraph::bEdge*, basicGraph::edgeCompare>::iterator e = graph->edgeBegin();
+		e != graph->edgeEnd(); e++)
+	{
+		const basicGraph::bEdge* edge = *e;
+		double w = edge->hasWeight() ?
+			static_cast<double>(dynamic_cast<const basicGraph::bWeightedEdge*>(edge)->weight()) : 1.0;
+		uint32_t cu = comm[edge->n1()->id()], cv = comm[edge->n2()->id()];
+		m2 += 2 * w;
+		if (cu == cv)
+			in += 2 * w;
+		tot[cu] += w;
+		tot[cv] += w;
+	}
+	double expected = 0;
+	for (map<uint32_t, double>::iterator c = tot.begin(); c != tot.end(); c++)
+		expected += (c->second / m2) * (c->second / m2);
+	return m2 ? in / m2 - expected : 0;
+}
+
+// ###
+// louvain: two triangles joined by an edge are two communities; on the
+// graph files the modularity reported is that of the communities found
+// and no lower than that of the singletons.
+// ###
+static void test_louvain(const string& dir)
+{
+	basicGraph::bGraph triangles(false);
+	const char* edges[][2] = { {"a", "b"}, {"b", "c"}, {"a", "c"}, {"d", "e"}, {"e", "f"}, {"d", "f"}, {"c", "d"} };
+	for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+		triangles.addNodesAndEdge(edges[i][0], edges[i][1], 1);
+	community::louvain split(&triangles);
+	split.build();
+	uint32_t left = split.community(triangles.findNode("a")), right = split.community(triangles.findNode("f"));
+	check(split.nCommunities() == 2 && left != right &&
+		split.community(triangles.findNode("b")) == left && split.community(triangles.findNode("c")) == left &&
+		split.community(triangles.findNode("d")) == right && split.community(triangles.findNode("e")) == right,
+		"louvain splits two triangles joined by an edge");
+	check(fabs(split.modularity() - 5.0 / 14) < 1e-9, "louvain modularity of two triangles is 5/14");
+
+	vector<string> files = graph_files(dir);
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		basicGraph::bGraph* graph = load(files[f]);
+		if (!graph)
+			continue;
+		community::louvain communities(graph);
+		communities.build();
+		vector<uint32_t> singletons(graph->nNodes());
+		for (size_t u = 0; u < singletons.size(); u++)
+			singletons[u] = static_cast<uint32_t>(u);
+		double q = modularity(graph, communities.communityIds());
+		check(fabs(communities.modularity() - q) < 1e-9, "louvain reports the modularity found on " + files[f]);
+		check(q >= modularity(graph, singletons) - 1e-12, "louvain gains on the singletons on " + files[f]);
+		delete graph;
+	}
+}
+
+// ###
+// props: a .props sidecar loads its columns, and path ... weight <column>
+// follows a real column without rounding it and an int column as is.
+// ###
+static string path_query(basicGraph::bGraph* graph, const properties::store& props,
+	const string& query, output::format fmt = output::TEXT)
+{
+	istringstream words(query);
+	vector<string> tokens;
+	for (string word; words >> word; )
+		tokens.push_back(word);
+	ostringstream out, err;
+	check(query::run(graph, tokens, out, err, fmt, nullptr, &props) == query::OK, query);
+	return out.str();
+}
+
+static void test_props(const string& dir)
+{
+	string file = dir + "/bga_test_props.txt";
+	ofstream out(file.c_str());
+	out << "graph undirected\na b\nb c\na c\n";
+	out.close();
+	ofstream sidecar((file + ".props").c_str());
+	sidecar << "node age int\na 34\nc 27\n";
+	sidecar << "edge latency real\na b 0.4\nb c 0.4\na c 0.6\n";
+	sidecar << "edge hops int\na b 1\nb c 1\na c 5\n";
+	sidecar.close();
+
+	basicGraph::bGraph* graph = load(file);
+	properties::store props;
+	bool loaded = false;
+	if (graph) {
+		ostringstream err;
+		loaded = props.load(file + ".props", graph, err);
+		check(loaded && err.str().empty(), "props load " + file + ".props");
+	}
+	remove(file.c_str());
+	remove((file + ".props").c_str());
+	if (!loaded) {
+		delete graph;
+		return;
+	}
+
+	const properties::column* age = props.nodes().find("age");
+	const properties::column* latency = props.edges().find("latency");
+	check(age && age->kind() == properties::INT && latency && latency->kind() == properties::REAL,
+		"props column types");
+	if (age) {
+		const basicGraph::bNode* a = graph->findNode("a");
+		const basicGraph::bNode* b = graph->findNode("b");
+		check(age->has(a->id()) && age->ints()[a->id()] == 34 && !age->has(b->id()), "props node values");
+	}
+
+	string real = path_query(graph, props, "path a c weight latency");
+	check(real.find("start --(0)--> a --(0.6)--> c ...done.") != string::npos &&
+		real.find("distance covered is 0.6.") != string::npos, "path on a real column is direct: " + real);
+	string csv = path_query(graph, props, "path a c weight latency", output::CSV);
+	check(csv == "node,dist,dist_from_src\na,0,0\nc,0.6,0.6\n", "path on a real column in csv: " + csv);
+	string all = path_query(graph, props, "path a weight latency", output::CSV);
+	check(all.find("b,0.4,a,0.4\n") != string::npos && all.find("c,0.6,a,0.6\n") != string::npos,
+		"paths on a real column from a: " + all);
+
+	string hops = path_query(graph, props, "path a c weight hops");
+	check(hops.find("a --(1)--> b --(1)--> c") != string::npos &&
+		hops.find("distance covered is 2.") != string::npos, "path on an int column goes round: " + hops);
+	delete graph;
+}
+
+// text as a tsv field of query::batch.
+static string tsv_field(const string& s)
+{
+	string text;
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		switch (s[i])
+		{
+		case '\\': text += "\\\\"; break;
+		case '\n': text += "\\n";  break;
+		case '\t': text += "\\t";  break;
+		case '\r': text += "\\r";  break;
+		default:   text += s[i];
+		}
+	}
+	return text;
+}
+
+static vector<string> split(const string& line, char separator)
+{
+	vector<string> fields;
+	istringstream in(line);
+	string field;
+	while (getline(in, field, separator))
+		fields.push_back(field);
+	if (!line.empty() && line[line.size() - 1] == separator)
+		fields.push_back("");
+	return fields;
+}
+
+// queries of every kind, over the first and the last node of graph.
+static vector<string> sample_queries(const basicGraph::bGraph* graph)
+{
+	string first = graph->node(0)->name(), last = graph->node(graph->nNodes() - 1)->name();
+	const char* kinds[] = { "scc", "cc", "search ", "sort", "mst", "mst prim", "path ", "path ", "scc ", "bogus" };
+	vector<string> queries;
+	for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++)
+		queries.push_back(kinds[i]);
+	queries[2] += first;
+	queries[6] += first + " " + last;
+	queries[7] += last;
+	queries[8] += last;
+	return queries;
+}
+
+// ###
+// batch: every query answered as query::run answers it alone, in input
+// order, over several windows; failing queries (mst on unweighted edges,
+// unknown commands) only fail their own line.
+// ###
+static void test_batch(const string& dir)
+{
+	vector<string> files = graph_files(dir);
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		basicGraph::bGraph* graph = load(files[f]);
+		if (!graph)
+			continue;
+		vector<string> queries = sample_queries(graph);
+		string input = "# comment\n\n";
+		for (size_t i = 0; i < queries.size(); i++)
+			input += queries[i] + "\n";
+
+		istringstream in(input);
+		ostringstream out;
+		query::batch answers(graph, query::batch::TSV, 3);
+		quiet([&]() { answers.run(in, out); });
+
+		vector<string> lines = split(out.str(), '\n');
+		if (!lines.empty() && lines.back().empty())
+			lines.pop_back();
+		check(lines.size() == queries.size() + 1, "batch answers every query of " + files[f]);
+		size_t wrong = 0, failed = 0;
+		for (size_t i = 0; i < queries.size() && i + 1 < lines.size(); i++)
+		{
+			vector<string> tokens = split(queries[i], ' ');
+			ostringstream expectOut, expectErr;
+			query::status status = query::run(graph, tokens, expectOut, expectErr);
+			if (status == query::UNKNOWN)
+				expectErr << "Error: option " << tokens[0] << " not supported in batch mode.\n";
+			failed += status != query::OK;
+
+			vector<string> fields = split(lines[i + 1], '\t');
+			wrong += fields.size() != 8 || fields[0] != to_string(i + 3) ||
+				fields[1] != (status == query::OK ? "ok" : "error") || fields[5] != queries[i] ||
+				fields[6] != tsv_field(expectOut.str()) || fields[7] != tsv_field(expectErr.str());
+		}
+		check(wrong == 0, "batch results equal query::run on " + files[f]);
+		check(answers.nQueries() == queries.size() && answers.nFailed() == failed,
+			"batch counts queries and failures on " + files[f]);
+		delete graph;
+	}
+}
+
+// ###
+// server: with one worker and two idle clients connected, a third client
+// is answered; responses equal query::run; shutdown returns although
+// clients are still connected.
+// ###
+static void test_server(const string& dir)
+{
+#ifndef _WIN32
+	vector<string> files = graph_files(dir);
+	string socketPath = dir + "/bga_test.sock";
+	for (size_t f = 0; f < files.size(); f++)
+	{
+		basicGraph::bGraph* graph = load(files[f]);
+		basicGraph::bGraph* served = load(files[f]);
+		if (!graph || !served) {
+			delete graph;
+			delete served;
+			continue;
+		}
+		// a server that stops answering would hang the test; fail it instead.
+		atomic<bool> finished(false);
+		thread watchdog([&]() {
+			for (int wait = 0; wait < 1000 && !finished.load(); wait++)
+				this_thread::sleep_for(chrono::milliseconds(10));
+			if (!finished.load()) {
+				fprintf(stderr, "FAIL: server of %s hangs, giving up.\n", files[f].c_str());
+				_Exit(1);
+			}
+		});
+
+		service::server server(served, files[f]);
+		atomic<bool> stopped(false);
+		thread serving([&]() {
+			quiet([&]() { server.serve(socketPath, 1); });
+			stopped.store(true);
+		});
+
+		service::client idle1, idle2, busy;
+		bool connected = false;
+		for (int attempt = 0; attempt < 100 && !connected; attempt++)
+		{
+			this_thread::sleep_for(chrono::milliseconds(10));
+			quiet([&]() { connected = idle1.connect(socketPath); });
+		}
+		quiet([&]() { connected = connected && idle2.connect(socketPath) && busy.connect(socketPath); });
+		check(connected, "clients connect to the server of " + files[f]);
+
+		vector<string> queries = sample_queries(graph);
+		queries.push_back("info");
+		size_t wrong = 0;
+		for (size_t i = 0; connected && i < queries.size(); i++)
+		{
+			bool ok = false;
+			string output, error;
+			if (!busy.request(queries[i], ok, output, error)) {
+				wrong++;
+				break;
+			}
+			if (queries[i] == "info") {
+				wrong += !ok || output.find(files[f]) == string::npos;
+				continue;
+			}
+			vector<string> tokens = split(queries[i], ' ');
+			ostringstream expectOut, expectErr;
+			query::status status = query::run(graph, tokens, expectOut, expectErr);
+			if (status == query::UNKNOWN)
+				expectErr << "Error: option " << tokens[0] << " not supported by the server.\n";
+			wrong += ok != (status == query::OK) || output != expectOut.str() || error != expectErr.str();
+		}
+		check(wrong == 0, "server answers equal query::run on " + files[f]);
+
+		bool ok = false;
+		string output, error;
+		check(connected && idle1.request("shutdown", ok, output, error) && ok, "server accepts shutdown");
+		serving.join();
+		check(stopped.load(), "server stops with idle clients connected on " + files[f]);
+		finished.store(true);
+		watchdog.join();
+		delete graph;
+	}
+#endif
+}
+
+// ###
+// parallel: reduce and exclusive_scan give exactly the sequential result
+// grouped in blocks of grain, whatever --threads is.
+// ###
+static void test_parallel(const string&)
+{
+	const size_t n = 1000003, grain = 1024;
+	double blocked = 0;
+	for (size_t lo = 0; lo < n; lo += grain)
+	{
+		double block = 0;
+		for (size_t i = lo; i < min(n, lo + grain); i++)
+			block += 1.0 / (i + 1);
+		blocked += block;
+	}
+	double sum = parallel::reduce(0, n, 0.0, [](size_t i) { return 1.0 / (i + 1); }, plus<double>(), grain);
+	check(sum == blocked, "reduce of doubles equals the sequential blocked sum");
+
+	vector<size_t> in(n), out(n);
+	for (size_t i = 0; i < n; i++)
+		in[i] = i % 7;
+	size_t total = parallel::exclusive_scan(in.data(), out.data(), n, size_t(0), plus<size_t>(), 1000);
+	size_t wrong = 0, acc = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		wrong += out[i] != acc;
+		acc += in[i];
+	}
+	check(wrong == 0 && total == acc, "exclusive_scan equals the sequential prefix sum");
+	check(parallel::reduce(5, 5, 3.0, [](size_t) { return 1.0; }, plus<double>()) == 3.0,
+		"reduce of an empty range is the identity");
+}
+
+// ###
+// dvector: copies, moves, inserts and erases match std::vector, inline
+// and on the heap.
+// ###
+template <unsigned N>
+static bool same(const dvector<string, N>& v, const vector<string>& ref)
+{
+	return v.size() == ref.size() && equal(ref.begin(), ref.end(), v.begin());
+}
+
+static void test_dvector(const string&)
+{
+	generators::splitmix rng(7);
+	dvector<string, 4> v;
+	vector<string>     ref;
+	for (size_t i = 0; i < 40; i++)
+	{
+		string s = "s" + to_string(i);
+		size_t at = rng.below(ref.size() + 1);
+		v.insert(at, s);
+		ref.insert(ref.begin() + at, s);
+		if (!check(same(v, ref), "dvector insert at " + to_string(at) + " of " + to_string(i)))
+			return;
+		if (i == 2 || i == 30) {
+			dvector<string, 4> copied(v);
+			check(same(copied, ref), "dvector copy of size " + to_string(ref.size()));
+			dvector<string, 4> assigned;
+			assigned.push_back("old");
+			assigned = v;
+			check(same(assigned, ref), "dvector copy assignment of size " + to_string(ref.size()));
+			dvector<string, 4> moved(move(copied));
+			check(same(moved, ref) && copied.size() == 0, "dvector move of size " + to_string(ref.size()));
+			assigned = move(moved);
+			check(same(assigned, ref) && moved.size() == 0, "dvector move assignment of size " + to_string(ref.size()));
+			check(assigned.on_heap() == (ref.size() > 4), "dvector inline up to its N elements");
+		}
+	}
+
+	v.push_back(v[0]); // aliases an element while the vector grows.
+	ref.push_back(ref[0]);
+	check(same(v, ref), "dvector push_back of its own element");
+	v.erase(3, 5);
+	ref.erase(ref.begin() + 3, ref.begin() + 8);
+	check(same(v, ref), "dvector erase");
+	v.shrink_to_fit();
+	check(same(v, ref) && v.capacity() == ref.size(), "dvector shrink_to_fit");
+	while (v.size() > 2)
+		v.pop_back();
+	ref.resize(2);
+	v.shrink_to_fit();
+	check(same(v, ref) && !v.on_heap(), "dvector back inline after shrink_to_fit");
+}
+
+// true if the edge list of every node is strictly in edgeCompare order.
+static bool edge_lists_sorted(const basicGraph::bGraph* graph)
+{
+	for (size_t id = 0; id < graph->nNodes(); id++)
+	{
+		const basicGraph::bNode* node = graph->node(id);
+		for (basicGraph::bNode::edgeIterator e = node->edgeBegin(); e != node->edgeEnd(); e++)
+			if (e != node->edgeBegin() && !basicGraph::edgeCompare()(*(e - 1), *e))
+				return false;
+	}
+	return true;
+}
+
+// ###
+// load: readBasicGraph appends edge lists and sorts them once; the lists
+// equal those built edge by edge with sorted inserts. The graphs have a
+// hub in random order, repeated edges and, undirected, both orientations
+// and self loops.
+// ###
+static void test_load(const string& dir)
+{
+	for (int directed = 1; directed >= 0; directed--)
+	{
+		string file = dir + "/bga_test_load.txt";
+		vector<pair<string, string>> lines;
+		generators::splitmix rng(directed + 11);
+		for (size_t i = 0; i < 3000; i++)
+		{
+			string from = rng.below(4) ? "hub" : "n" + to_string(rng.below(64));
+			string to   = "n" + to_string(rng.below(600));
+			lines.push_back(make_pair(from, to));
+			if (rng.below(10) == 0)
+				lines.push_back(directed ? lines.back() : make_pair(to, from));
+			if (!directed && rng.below(50) == 0)
+				lines.push_back(make_pair(from, from));
+		}
+		ofstream out(file.c_str());
+		out << "graph " << (directed ? "directed" : "undirected") << "\n";
+		for (size_t i = 0; i < lines.size(); i++)
+			out << lines[i].first << " " << lines[i].second << " 7\n";
+		out.close();
+
+		basicGraph::bGraph* graph = load(file);
+		remove(file.c_str());
+		if (!graph)
+			continue;
+		basicGraph::bGraph reference(directed != 0);
+		for (size_t i = 0; i < lines.size(); i++)
+			reference.addNodesAndEdge(lines[i].first, lines[i].second, 7);
+
+		string kind = directed ? "directed" : "undirected";
+		bool same = graph->nNodes() == reference.nNodes() && graph->nEdges() == reference.nEdges();
+		for (size_t id = 0; same && id < graph->nNodes(); id++)
+		{
+			const basicGraph::bNode* a = graph->node(id);
+			const basicGraph::bNode* b = reference.node(id);
+			same = a->name() == b->name() && a->degree() == b->degree();
+			for (size_t i = 0; same && i < a->degree(); i++)
+				same = a->edgeBegin()[i]->name() == b->edgeBegin()[i]->name();
+		}
+		check(same, "loaded edge lists equal sorted inserts, " + kind);
+		check(edge_lists_sorted(graph), "loaded edge lists sorted without repeats, " + kind);
+		if (directed) {
+			const basicGraph::bGraph* reversed = nullptr;
+			quiet([&]() { reversed = transpose(false).build(graph); });
+			check(edge_lists_sorted(reversed), "transposed edge lists sorted without repeats");
+			delete reversed;
+		}
+		delete graph;
+	}
+}
+
+struct testCase {
+	const char* name_;
+	void (*run_)(const string& dir);
+};
+
+static const testCase tests[] = {
+	{ "parallel", test_parallel },
+	{ "dvector", test_dvector },
+	{ "load",  test_load },
+	{ "scc",   test_scc },
+	{ "cc",    test_cc },
+	{ "triangles", test_triangles },
+	{ "kcore", test_kcore },
+	{ "maxflow", test_maxflow },
+	{ "reach", test_reach },
+	{ "pagerank", test_pagerank },
+	{ "louvain", test_louvain },
+	{ "props", test_props },
+	{ "batch", test_batch },
+	{ "server", test_server },
+};
+
+int main(int argc, char** argv)
+{
+	string         dir = ".";
+	vector<string> selected;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg != "--dir" && arg != "--threads") {
+			selected.push_back(arg);
+			continue;
+		}
+		if (i + 1 >= argc) {
+			cerr << "Error: option " << arg << " needs a value.\n";
+			return 1;
+		}
+		string value = argv[++i];
+		if (arg == "--dir")
+			dir = value;
+		else if (!parallel::setThreads(strtoul(value.c_str(), nullptr, 10))) {
+			cerr << "Error: invalid thread count " << value << ".\n";
+			return 1;
+		}
+	}
+
+	string generated = dir + "/bga_test_rmat.txt";
+	if (!generators::write(generated, "rmat", 8, 8, 1)) {
+		cerr << "Error: could not write " << generated << ".\n";
+		return 1;
+	}
+
+	size_t nTests = sizeof(tests) / sizeof(tests[0]);
+	for (size_t s = 0; s < selected.size(); s++)
+	{
+		size_t t = 0;
+		while (t < nTests && selected[s] != tests[t].name_)
+			t++;
+		if (t == nTests) {
+			cerr << "Error: test " << selected[s] << " not found.\n";
+			remove(generated.c_str());
+			return 1;
+		}
+	}
+	for (size_t t = 0; t < nTests; t++)
+	{
+		if (!selected.empty() && find(selected.begin(), selected.end(), tests[t].name_) == selected.end())
+			continue;
+		size_t failures = nFailures;
+		tests[t].run_(dir);
+		cout << tests[t].name_ << (nFailures == failures ? " ok" : " FAILED") << "\n";
+	}
+	remove(generated.c_str());
+
+	cout << nChecks << " checks, " << nFailures << " failed.\n";
+	return nFailures ? 1 : 0;
+}